@@ -0,0 +1,159 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "fault_dump.h"
+#include "trace_encode.h"
+
+/*
+ * The write function of the retarget layer (logging/retarget.c) for the
+ * toolchain. Going around stdio keeps the C library formatter and its
+ * buffering out of the fault path, stdout is flushed before so nothing
+ * printed earlier comes out after the dump.
+ */
+#if defined(__ARMCC_VERSION)
+#include <rt_sys.h>
+#define FAULT_STDOUT 0x8002
+#define fault_write(buf, len) _sys_write(FAULT_STDOUT, (const unsigned char *)(buf), (len), 0)
+#elif defined(__ICCARM__)
+#define FAULT_STDOUT 0x01
+size_t __write(int handle, const unsigned char *buf, size_t len);
+#define fault_write(buf, len) __write(FAULT_STDOUT, (const unsigned char *)(buf), (len))
+#else
+#define FAULT_STDOUT 0x01
+int _write(int fh, const unsigned char *buf, unsigned int len, int mode);
+#define fault_write(buf, len) _write(FAULT_STDOUT, (const unsigned char *)(buf), (len), 0)
+#endif
+
+#define fault_write_str(str) fault_write(str, sizeof(str) - 1)
+
+// with the rest of the M-profile fault handler, see fault_handler.c
+#if defined(A32)
+#define FAULT_HANDLER_XO_MEMORY_LOCATION
+#else
+#define FAULT_HANDLER_XO_MEMORY_LOCATION __attribute__((section(".text.slow")))
+#endif
+
+// these are for readability(?), can't be changed without modifying code below
+#define VALUES_PER_LINE 4
+#define BYTES_IN_VALUE 4
+
+FAULT_HANDLER_XO_MEMORY_LOCATION
+void fault_dump_registers(const uint32_t *regs, uint32_t count)
+{
+    // "R12 = 0000000C " per register
+    char line[VALUES_PER_LINE * 15];
+    uint32_t len = 0;
+
+    fflush(stdout);
+    for (uint32_t i = 0; i < count; i++) {
+        line[len++] = 'R';
+        const uint32_t digits = trace_encode_dec32(&line[len], i);
+        memset(&line[len + digits], ' ', 3 - digits);
+        len += 3;
+        line[len++] = '=';
+        line[len++] = ' ';
+        trace_encode_hex32(&line[len], &regs[i], 1);
+        len += 8;
+        line[len++] = i % VALUES_PER_LINE < VALUES_PER_LINE - 1 ? ' ' : '\n';
+        if (i % VALUES_PER_LINE == VALUES_PER_LINE - 1 || i == count - 1) {
+            fault_write(line, len);
+            len = 0;
+        }
+    }
+}
+
+/*
+ * One line of the stack dump. Only the first and the last line can be
+ * partial, their words outside the stack are left blank.
+ */
+FAULT_HANDLER_XO_MEMORY_LOCATION
+static void dump_line(const uint32_t *p, uintptr_t stack_point, uintptr_t stack_top)
+{
+    char line[8 + 2 + VALUES_PER_LINE * 12 + 4 + VALUES_PER_LINE * BYTES_IN_VALUE + 1];
+    char *lp = line;
+    const uint32_t address = (uint32_t)(uintptr_t)p;
+    const bool full = p >= (const uint32_t *)stack_point && p + VALUES_PER_LINE <= (const uint32_t *)stack_top;
+
+    trace_encode_hex32(lp, &address, 1);
+    lp += 8;
+    *lp++ = ' ';
+    *lp++ = ':';
+
+    // the stack values for 1 line
+    char hex[VALUES_PER_LINE * 8];
+    if (full) {
+        trace_encode_hex32(hex, p, VALUES_PER_LINE);
+    }
+    for (uint32_t i = 0; i < VALUES_PER_LINE; i++) {
+        const uint32_t *vp = p + i;
+        memset(lp, ' ', 4);
+        lp += 4;
+        if (vp >= (const uint32_t *)stack_point && vp < (const uint32_t *)stack_top) {
+            if (!full) {
+                trace_encode_hex32(&hex[i * 8], vp, 1);
+            }
+            memcpy(lp, &hex[i * 8], 8);
+        }
+        else {
+            memset(lp, ' ', 8);
+        }
+        lp += 8;
+    }
+    memset(lp, ' ', 4);
+    lp += 4;
+
+    // the ascii characters for one line, only printable ones
+    if (full) {
+        trace_encode_ascii(lp, p, VALUES_PER_LINE * BYTES_IN_VALUE);
+        lp += VALUES_PER_LINE * BYTES_IN_VALUE;
+    }
+    else {
+        for (const char *cp = (const char *)p; cp < (const char *)p + VALUES_PER_LINE * BYTES_IN_VALUE; cp++) {
+            if (cp >= (const char *)stack_point && cp < (const char *)stack_top) {
+                trace_encode_ascii(lp, cp, 1);
+            }
+            else {
+                *lp = ' ';
+            }
+            lp++;
+        }
+    }
+    *lp++ = '\n';
+    fault_write(line, lp - line);
+}
+
+FAULT_HANDLER_XO_MEMORY_LOCATION
+void fault_dump_stack(uintptr_t stack_point, uintptr_t stack_top, uint32_t max_lines)
+{
+    fflush(stdout);
+    fault_write_str("\n==== Stack dump ====\n\n");
+
+    // not using the default stack so we have to just
+    // print the defined maximum (max_lines)
+    if (stack_top < stack_point) {
+        stack_top = UINTPTR_MAX;
+    }
+
+    // start printing from aligned address
+    const uintptr_t loop_start = stack_point - stack_point % (VALUES_PER_LINE * BYTES_IN_VALUE);
+    const uint32_t *const end = (const uint32_t *)loop_start + max_lines * VALUES_PER_LINE;
+
+    // Dump uint32 values from SP until stack top or until max_lines lines are printed
+    fault_write_str("Address  :     3 2 1 0     7 6 5 4     B A 9 8     F E D C       ASCII Data\n");
+    //               80008010 :    FFEEAABB    CC001133    12345678    1A2B3C4D    ....3...xV".M<+.
+    for (const uint32_t *p = (const uint32_t *)loop_start; p < end && p < (const uint32_t *)stack_top;
+         p += VALUES_PER_LINE) {
+        dump_line(p, stack_point, stack_top);
+    }
+}
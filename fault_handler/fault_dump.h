@@ -0,0 +1,45 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+/*
+ * Dump output shared by the M-profile (fault_handler.c) and A-profile
+ * (fault_handler_a.c) fault handlers. Every line is built with the
+ * trace_encode kernels and handed to the retarget _write in one piece.
+ */
+
+#ifndef FAULT_DUMP_H
+#define FAULT_DUMP_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Write "R0  = 00000000" style entries, four per line.
+ *
+ * A last partial line is left open with a trailing space.
+ */
+void fault_dump_registers(const uint32_t *regs, uint32_t count);
+
+/**
+ * @brief Write the stack dump from stack_point up to stack_top, at most
+ *        max_lines lines of 16 bytes with their ASCII characters.
+ *
+ * @param stack_top UINTPTR_MAX when not known
+ */
+void fault_dump_stack(uintptr_t stack_point, uintptr_t stack_top, uint32_t max_lines);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FAULT_DUMP_H */
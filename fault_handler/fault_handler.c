@@ -16,6 +16,7 @@
 #include "RTE_Device.h"
 #include "RTE_Components.h"
 
+#include "fault_dump.h"
 #include "fault_handler.h"
 
 #include CMSIS_device_header
@@ -450,9 +451,7 @@ static void FaultDump(void)
 
     printf("\nEXC_RETURN = %08" PRIX32 "\n\n"
            "Register dump (stored at &%08" PRIXPTR ") is:\n", exc_return, (uintptr_t) regs);
-    for (int i = 0; i < 13; i++) {
-        printf("R%-3d= %08" PRIX32 "%c", i, regs[i], i % 4 < 3 ? ' ' : '\n');
-    }
+    fault_dump_registers(regs, 13);
     printf("SP  = %08" PRIX32 " LR  = %08" PRIX32 " PC  = %08" PRIX32 "\n", regs[13], regs[14], regs[15]);
     printf("Mode %-8sflags set: ", exc_return & 8 ? "Thread" : "Handler");
     for (size_t i = 0, bit = 1u<<31; i < 24; i++) {
@@ -472,56 +471,7 @@ static void FaultDump(void)
 
     uintptr_t stack_top = VTOR_STACK_TOP;
     printf("Stack top from VTOR: %08" PRIXPTR "\n", stack_top);
-    printf("\n==== Stack dump ====\n\n");
-    const uintptr_t stack_point = regs[13];
-
-    // not using the default stack so we have to just
-    // print the defined maximum (STACK_DUMP_MAX_LINES)
-    if (stack_top < stack_point) {
-        stack_top = UINTPTR_MAX;
-    }
-
-    // these are for readability(?), can't be changed without modifying code below
-    #define VALUES_PER_LINE 4
-    #define BYTES_IN_VALUE 4
-
-    // start printing from aligned address
-    const uintptr_t loop_start = stack_point - stack_point % (VALUES_PER_LINE * BYTES_IN_VALUE);
-
-    // Dump uint32 values from SP until stack top or until defined number of lines is printed
-    printf("Address  :     3 2 1 0     7 6 5 4     B A 9 8     F E D C       ASCII Data\n");
-    //      80008010 :    FFEEAABB    CC001133    12345678    1A2B3C4D    ....3...xV".M<+.
-    for (uint32_t *p = (uint32_t *)loop_start; p < ((uint32_t *)loop_start + STACK_DUMP_MAX_LINES * VALUES_PER_LINE) && p < (uint32_t *)stack_top; p += VALUES_PER_LINE) {
-
-        printf("%08" PRIXPTR " :", (uintptr_t)p);
-        // print the stack values for 1 line
-        for (uint32_t *vp = p; vp < p + VALUES_PER_LINE; vp++) {
-            if (vp >= (uint32_t*)stack_point && vp < (uint32_t*)stack_top) {
-                printf("    %08" PRIX32, *vp);
-            }
-            else {
-                printf("            ");
-            }
-        }
-        printf("    ");
-
-        // print the ascii characters for one line
-        for (char *cp = (char *)p; cp < (char *)p + VALUES_PER_LINE * BYTES_IN_VALUE; cp++) {
-            if (cp >= (char*)stack_point && cp < (char*)stack_top) {
-                // only print printable ascii characters
-                if(*cp > 31 && *cp < 127) {
-                    putchar(*cp);
-                }
-                else {
-                    putchar('.');
-                }
-            }
-            else {
-                putchar(' ');
-            }
-        }
-        printf("\n");
-    }
+    fault_dump_stack(regs[13], stack_top, STACK_DUMP_MAX_LINES);
 
     for (;;) {
         __WFE();
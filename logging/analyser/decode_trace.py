@@ -0,0 +1,258 @@
+import argparse
+import json
+import re
+import struct
+import sys
+
+## Binary record layout, keep in sync with TRACELIB_DEFERRED_FORMAT in uart_tracelib.h
+_RECORD_MARKER = 0xA5
+_RECORD_HEADER = struct.Struct("<BHII")
+
+## Structured record framing, keep in sync with TRACELIB_KV_* in uart_tracelib.h
+_KV_RECORD_MARKER = 0xA6
+_KV_TAG_CYCLES = 6
+
+## %[flags][width][.precision][length]conversion
+_CONVERSION_RE = re.compile(r"%([-+ #0]*)(\*|[0-9]*)(?:\.(\*|[0-9]*))?(hh|h|ll|l|j|z|t|L)?([diuxXocfFeEgGaAspn%])")
+
+_SHF_ALLOC = 0x2
+_SHT_NOBITS = 8
+
+
+class ElfImage:
+    """Minimal 32-bit little endian ELF reader for looking up strings by address."""
+
+    def __init__(self, elf_file: str):
+        with open(elf_file, "rb") as f:
+            data = f.read()
+        if data[:4] != b"\x7fELF" or data[4] != 1 or data[5] != 1:
+            raise ValueError("%s is not a 32-bit little endian ELF file" % elf_file)
+
+        e_shoff, = struct.unpack_from("<I", data, 0x20)
+        e_shentsize, e_shnum = struct.unpack_from("<HH", data, 0x2E)
+        self._sections = []
+        for i in range(e_shnum):
+            _, sh_type, sh_flags, sh_addr, sh_offset, sh_size = struct.unpack_from("<IIIIII", data, e_shoff + i * e_shentsize)
+            if sh_flags & _SHF_ALLOC and sh_type != _SHT_NOBITS and sh_size:
+                self._sections.append((sh_addr, sh_addr + sh_size, data[sh_offset:sh_offset + sh_size]))
+
+    def string_at(self, address: int):
+        for start, end, content in self._sections:
+            if start <= address < end:
+                offset = address - start
+                try:
+                    end = content.index(b"\0", offset)
+                except ValueError:
+                    return None
+                return content[offset:end].decode("UTF-8", errors="replace")
+        return None
+
+
+class RecordDecoder:
+    def __init__(self, elf: ElfImage, show_timestamp: bool=False, delta_timestamp: bool=False):
+        self._elf = elf
+        self._show_timestamp = show_timestamp or delta_timestamp
+        self._delta_timestamp = delta_timestamp
+        self._previous_timestamp = None
+        self._formats = {}
+
+    def _format_string(self, fmt_id: int):
+        if fmt_id not in self._formats:
+            self._formats[fmt_id] = self._elf.string_at(fmt_id)
+        return self._formats[fmt_id]
+
+    def decode(self, fmt_id: int, timestamp: int, payload: bytes):
+        fmt = self._format_string(fmt_id)
+        if fmt is None:
+            # not a record, e.g. a 0xA5 byte in plain text or raw binary output
+            return None
+        text = self._render(fmt, payload)
+        if self._delta_timestamp:
+            # the 32-bit counter wraps, modulo arithmetic keeps the deltas right
+            delta = 0 if self._previous_timestamp is None else (timestamp - self._previous_timestamp) & 0xFFFFFFFF
+            self._previous_timestamp = timestamp
+            text = "[+%d] %s" % (delta, text)
+        elif self._show_timestamp:
+            text = "[%10d] %s" % (timestamp, text)
+        return text
+
+    def _render(self, fmt: str, payload: bytes):
+        offset = 0
+
+        def take(size: int, code: str):
+            nonlocal offset
+            if offset + size > len(payload):
+                raise IndexError
+            value, = struct.unpack_from("<" + code, payload, offset)
+            offset += size
+            return value
+
+        def convert(match):
+            nonlocal offset
+            flags, width, precision, length, conversion = match.groups()
+            if conversion == "%":
+                return "%"
+            if conversion == "n":
+                return ""
+            try:
+                if width == "*":
+                    width = str(take(4, "i"))
+                if precision == "*":
+                    precision = str(take(4, "i"))
+                spec = "%" + flags + (width or "") + ("." + precision if precision is not None else "")
+
+                if conversion == "s":
+                    size = take(1, "B")
+                    value = payload[offset:offset + size].decode("UTF-8", errors="replace")
+                    offset += size
+                    return (spec + "s") % value
+                if conversion == "p":
+                    return "0x%08x" % take(4, "I")
+                if conversion in "fFeEgGaA":
+                    value = take(8, "d")
+                    if conversion in "aA":
+                        return value.hex()
+                    return (spec + conversion) % value
+                wide = length in ("ll", "j")
+                signed = conversion in "di"
+                value = take(8 if wide else 4, ("q" if signed else "Q") if wide else ("i" if signed else "I"))
+                if length == "hh":
+                    value &= 0xFF
+                elif length == "h":
+                    value &= 0xFFFF
+                if conversion == "c":
+                    return (spec + "c") % chr(value & 0xFF)
+                return (spec + conversion) % value
+            except IndexError:
+                return "<?>"
+
+        return _CONVERSION_RE.sub(convert, fmt)
+
+
+class CborReader:
+    """Decoder for the CBOR subset written by tracelib_kv_*."""
+
+    def __init__(self, data: bytes):
+        self._data = data
+        self.pos = 0
+
+    def _take(self, size: int):
+        if self.pos + size > len(self._data):
+            raise ValueError("truncated CBOR item")
+        value = self._data[self.pos:self.pos + size]
+        self.pos += size
+        return value
+
+    def _argument(self, info: int):
+        if info < 24:
+            return info
+        if info > 27:
+            raise ValueError("unsupported CBOR argument %d" % info)
+        return int.from_bytes(self._take(1 << (info - 24)), "big")
+
+    def item(self):
+        initial = self._take(1)[0]
+        major, info = initial >> 5, initial & 0x1F
+        if major == 7:
+            if info == 25:
+                return struct.unpack(">e", self._take(2))[0]
+            if info == 26:
+                return struct.unpack(">f", self._take(4))[0]
+            if info == 27:
+                return struct.unpack(">d", self._take(8))[0]
+            return {20: False, 21: True, 22: None}.get(info)
+        if info == 31:
+            if major != 5:
+                raise ValueError("unsupported indefinite length item")
+            result = {}
+            while self._data[self.pos] != 0xFF:
+                key = self.item()
+                result[key] = self.item()
+            self.pos += 1
+            return result
+
+        value = self._argument(info)
+        if major == 0:
+            return value
+        if major == 1:
+            return -1 - value
+        if major == 2:
+            return self._take(value).hex()
+        if major == 3:
+            return self._take(value).decode("UTF-8", errors="replace")
+        if major == 4:
+            return [self.item() for _ in range(value)]
+        if major == 5:
+            return {self.item(): self.item() for _ in range(value)}
+        # tags, the cycle count tag is plain integer in JSON
+        return self.item()
+
+
+def decode_kv(body: bytes):
+    """Returns the JSON line of a structured record body or None if it is not valid."""
+    if not body or body[0] != 0xBF or body[-1] != 0xFF:
+        return None
+    try:
+        reader = CborReader(body)
+        fields = reader.item()
+    except (ValueError, IndexError, struct.error):
+        return None
+    if reader.pos != len(body):
+        return None
+    return json.dumps(fields) + "\n"
+
+
+def decode_stream(data: bytes, decoder: RecordDecoder, out):
+    pos = 0
+    text_start = 0
+    while pos < len(data):
+        marker = data[pos]
+        if marker not in (_RECORD_MARKER, _KV_RECORD_MARKER) or pos + 3 > len(data):
+            pos += 1
+            continue
+
+        length, = struct.unpack_from("<H", data, pos + 1)
+        end = pos + 3 + length
+        if end > len(data):
+            pos += 1
+            continue
+
+        if marker == _KV_RECORD_MARKER:
+            text = decode_kv(data[pos + 3:end])
+        elif decoder is not None and length >= _RECORD_HEADER.size - 3:
+            _, _, fmt_id, timestamp = _RECORD_HEADER.unpack_from(data, pos)
+            text = decoder.decode(fmt_id, timestamp, data[pos + _RECORD_HEADER.size:end])
+        else:
+            text = None
+        if text is None:
+            pos += 1
+            continue
+
+        # plain text output (printf retarget etc.) is passed through as is
+        out.write(data[text_start:pos].decode("UTF-8", errors="replace"))
+        out.write(text)
+        pos = end
+        text_start = pos
+    out.write(data[text_start:].decode("UTF-8", errors="replace"))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decodes binary tracelib records (TRACELIB_DEFERRED_FORMAT) captured from UART back to text using the format strings from the elf file. Structured records (tracelib_kv_*) are written as JSON lines.")
+    parser.add_argument("capture_filename", help="Raw UART capture, '-' reads from stdin")
+    parser.add_argument("elf_filename", nargs="?", help="Needed for TRACELIB_DEFERRED_FORMAT records only")
+    parser.add_argument('-t', '--timestamps', action='store_true', help="Prefix every decoded line with the cycle count timestamp.")
+    parser.add_argument('-d', '--delta', action='store_true', help="Prefix every decoded line with the cycles since the previous record.")
+    args = parser.parse_args()
+
+    if args.capture_filename == "-":
+        data = sys.stdin.buffer.read()
+    else:
+        with open(args.capture_filename, "rb") as f:
+            data = f.read()
+
+    decoder = RecordDecoder(ElfImage(args.elf_filename), args.timestamps, args.delta) if args.elf_filename else None
+    decode_stream(data, decoder, sys.stdout)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,101 @@
+import argparse
+import re
+import sys
+import time
+
+try:
+    import serial
+except ImportError:
+    sys.exit("trace_capture.py needs pyserial: pip install pyserial")
+
+## Baud rate handshake, keep in sync with TRACELIB_BAUD_* in uart_tracelib.h
+_BAUD_REQUEST_RE = re.compile(rb"@tracelib baud (\d+)\r?\n")
+_BAUD_ACCEPT = b"@tracelib baud ok\n"
+_BAUD_REJECT = b"@tracelib baud no\n"
+_BAUD_SYNC = b"@tracelib sync"
+
+
+class TraceCapture:
+    """Copies the UART output to a stream and answers baud rate requests from tracelib."""
+
+    def __init__(self, port: serial.Serial, out, max_baudrate: int, timeout: float):
+        self._port = port
+        self._out = out
+        self._max_baudrate = max_baudrate
+        self._timeout = timeout
+        self._pending = b""
+
+    def _write_out(self, data: bytes):
+        self._out.write(data)
+        self._out.flush()
+
+    def _read_until(self, token: bytes, timeout: float):
+        data = b""
+        deadline = time.monotonic() + timeout
+        while time.monotonic() < deadline:
+            data += self._port.read(self._port.in_waiting or 1)
+            if token in data:
+                return data
+        return None
+
+    def _switch(self, baudrate: int):
+        previous = self._port.baudrate
+        if baudrate > self._max_baudrate:
+            self._port.write(_BAUD_REJECT)
+            return
+
+        self._port.write(_BAUD_ACCEPT)
+        self._port.flush()
+        # the target drains its output before switching, anything received
+        # in between is garbage at one of the two rates
+        self._port.baudrate = baudrate
+        self._port.reset_input_buffer()
+        if self._read_until(_BAUD_SYNC, self._timeout) is None:
+            self._port.baudrate = previous
+            print("baud rate switch to %d failed, staying at %d" % (baudrate, previous), file=sys.stderr)
+            return
+        self._port.write(_BAUD_SYNC + b"\n")
+        # drop the repeated sync lines sent before the echo arrived
+        time.sleep(0.02)
+        self._port.reset_input_buffer()
+        print("switched to %d baud" % baudrate, file=sys.stderr)
+
+    def run(self):
+        while True:
+            self._pending += self._port.read(self._port.in_waiting or 1)
+            match = _BAUD_REQUEST_RE.search(self._pending)
+            if match:
+                self._write_out(self._pending[:match.start()])
+                self._pending = b""
+                self._switch(int(match.group(1)))
+                continue
+
+            # keep a possible partial request line for the next read
+            keep = self._pending.rfind(b"@")
+            if keep < 0 or len(self._pending) - keep > 32:
+                keep = len(self._pending)
+            self._write_out(self._pending[:keep])
+            self._pending = self._pending[keep:]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Captures tracelib output from a serial port and answers the baud rate handshake of tracelib_set_baudrate.")
+    parser.add_argument("port", help="Serial port, e.g. /dev/ttyUSB0 or COM3")
+    parser.add_argument('-b', '--baudrate', type=int, default=115200, help="Initial baud rate (TRACELIB_UART_BAUDRATE).")
+    parser.add_argument('-m', '--max-baudrate', type=int, default=3000000, help="Highest baud rate accepted from the target.")
+    parser.add_argument('-t', '--timeout', type=float, default=0.1, help="Seconds to wait for the target at the new rate.")
+    parser.add_argument('-o', '--output', help="Write the capture to a file instead of stdout, e.g. for decode_trace.py.")
+    args = parser.parse_args()
+
+    out = open(args.output, "wb") if args.output else sys.stdout.buffer
+    with serial.Serial(args.port, args.baudrate, timeout=0.01) as port:
+        try:
+            TraceCapture(port, out, args.max_baudrate, args.timeout).run()
+        except KeyboardInterrupt:
+            pass
+    if args.output:
+        out.close()
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,19 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+/* Board UARTs of the Linux host build, all are stand-in drivers (host_usart.c) */
+
+#ifndef BOARD_DEFS_H
+#define BOARD_DEFS_H
+
+#define BOARD_UART1_INSTANCE 1
+#define BOARD_UART2_INSTANCE 2
+
+#endif /* BOARD_DEFS_H */
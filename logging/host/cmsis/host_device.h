@@ -0,0 +1,181 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+/*
+ * CMSIS device header stand-in for the Linux host build of logging/ (see
+ * logging/host/CMakeLists.txt). Only what logging/ and profiling/ use is
+ * provided.
+ *
+ * Interrupts are modelled with threads: the stand-in USART drivers run their
+ * events on their own thread with IPSR set, and masking interrupts takes one
+ * process wide lock that the event threads also take. Unlike on a single
+ * core, application threads still run in parallel with the "ISRs", which is
+ * what the lock-free paths have to cope with on the multi-core channel too.
+ */
+
+#ifndef HOST_DEVICE_H_
+#define HOST_DEVICE_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define __STATIC_FORCEINLINE    static inline __attribute__((always_inline))
+#define __STATIC_INLINE         static inline
+#define __ALIGNED(x)            __attribute__((aligned(x)))
+#define __WEAK                  __attribute__((weak))
+#define __USED                  __attribute__((used))
+#define __NO_RETURN             __attribute__((noreturn))
+#define __BKPT(value)           host_breakpoint(value)
+
+#define __CM_CMSIS_VERSION_MAIN 5U
+#define __NVIC_PRIO_BITS        8U
+
+typedef enum {
+    PendSV_IRQn = -2,
+    SysTick_IRQn = -1,
+    HOST_USART_IRQn = 16,   /* IPSR of the stand-in driver event threads is 16 + n */
+} IRQn_Type;
+
+/* Interrupt state of the calling thread */
+extern __thread uint32_t host_ipsr;
+extern __thread uint32_t host_primask;
+
+void host_irq_lock(void);
+void host_irq_unlock(void);
+void host_wfe(void);
+void host_breakpoint(uint32_t value);
+
+__STATIC_FORCEINLINE uint32_t __get_IPSR(void)
+{
+    return host_ipsr;
+}
+
+__STATIC_FORCEINLINE uint32_t __get_PRIMASK(void)
+{
+    return host_primask;
+}
+
+__STATIC_FORCEINLINE void __disable_irq(void)
+{
+    if (host_primask == 0U) {
+        host_irq_lock();
+        host_primask = 1U;
+    }
+}
+
+__STATIC_FORCEINLINE void __enable_irq(void)
+{
+    if (host_primask != 0U) {
+        host_primask = 0U;
+        host_irq_unlock();
+    }
+}
+
+__STATIC_FORCEINLINE void __set_PRIMASK(uint32_t priMask)
+{
+    if (priMask & 1U) {
+        __disable_irq();
+    } else {
+        __enable_irq();
+    }
+}
+
+#define __WFE()     host_wfe()
+#define __WFI()     host_wfe()
+#define __SEV()     ((void)0)
+#define __NOP()     ((void)0)
+#define __DMB()     __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define __DSB()     __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define __ISB()     __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+/*
+ * Core registers. DWT->CYCCNT counts SystemCoreClock cycles of the monotonic
+ * clock, every access reads the clock into a per thread register block.
+ */
+typedef struct {
+    volatile uint32_t DEMCR;
+} DCB_Type;
+
+#define DCB_DEMCR_TRCENA_Msk        (1UL << 24)
+
+typedef struct {
+    volatile uint32_t CTRL;
+    volatile uint32_t CYCCNT;
+} DWT_Type;
+
+#define DWT_CTRL_CYCCNTENA_Msk      (1UL << 0)
+
+typedef struct {
+    volatile uint32_t CTRL;
+    volatile uint32_t LOAD;
+    volatile uint32_t VAL;
+} SysTick_Type;
+
+#define SysTick_CTRL_ENABLE_Pos     0U
+
+typedef struct {
+    volatile uint32_t ICSR;
+} SCB_Type;
+
+#define SCB_ICSR_PENDSVSET_Msk      (1UL << 28)
+
+/*
+ * ITM with the stimulus port access sizes in separate fields, so that a write
+ * can be told from the poll value. See host_itm.h.
+ */
+typedef struct {
+    struct {
+        volatile uint8_t u8;
+        volatile uint16_t u16;
+        volatile uint32_t u32;
+    } PORT[32];
+    volatile uint32_t TER;
+    volatile uint32_t TCR;
+} ITM_Type;
+
+#define ITM_TCR_ITMENA_Msk          (1UL << 0)
+
+DWT_Type *host_dwt(void);
+
+extern DCB_Type host_dcb;
+extern SysTick_Type host_systick;
+extern SCB_Type host_scb;
+ITM_Type *host_itm_regs(void);
+
+#define DCB         (&host_dcb)
+#define DWT         (host_dwt())
+#define SysTick     (&host_systick)
+#define SCB         (&host_scb)
+#define ITM         (host_itm_regs())
+
+extern uint32_t SystemCoreClock;
+uint32_t GetSystemCoreClock(void);
+
+__STATIC_INLINE uint32_t SysTick_Config(uint32_t ticks)
+{
+    SysTick->LOAD = ticks - 1U;
+    SysTick->CTRL = 1UL << SysTick_CTRL_ENABLE_Pos;
+    return 0U;
+}
+
+__STATIC_INLINE void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority)
+{
+    (void)IRQn;
+    (void)priority;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_DEVICE_H_ */
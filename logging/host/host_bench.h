@@ -0,0 +1,76 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+/*
+ * Timing helpers of the host benchmarks. Latencies are wall clock
+ * nanoseconds per call on the build machine, compare them between builds of
+ * the same machine only.
+ */
+
+#ifndef HOST_BENCH_H_
+#define HOST_BENCH_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+typedef struct {
+    uint32_t count;
+    uint32_t size;
+    uint32_t *samples;      /* nanoseconds per call */
+} bench_latency_t;
+
+static inline uint64_t bench_now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000U + (uint64_t)now.tv_nsec;
+}
+
+static inline void bench_latency_init(bench_latency_t *lat, uint32_t size)
+{
+    lat->count = 0;
+    lat->size = size;
+    lat->samples = malloc(size * sizeof(lat->samples[0]));
+}
+
+static inline void bench_latency_add(bench_latency_t *lat, uint64_t ns)
+{
+    if (lat->count < lat->size) {
+        lat->samples[lat->count++] = ns > UINT32_MAX ? UINT32_MAX : (uint32_t)ns;
+    }
+}
+
+static int bench_compare(const void *a, const void *b)
+{
+    const uint32_t x = *(const uint32_t *)a;
+    const uint32_t y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+/* Print a "name median p99 max" row and free the samples */
+static inline void bench_latency_report(const char *name, bench_latency_t *lat)
+{
+    if (lat->count) {
+        qsort(lat->samples, lat->count, sizeof(lat->samples[0]), bench_compare);
+        printf("  %-36s %8u %8u %8u\n", name, lat->samples[lat->count / 2],
+               lat->samples[(uint64_t)lat->count * 99 / 100], lat->samples[lat->count - 1]);
+    }
+    free(lat->samples);
+    lat->samples = NULL;
+}
+
+static inline void bench_latency_header(const char *title)
+{
+    printf("\n%s\n  %-36s %8s %8s %8s\n", title, "ns per call", "median", "p99", "max");
+}
+
+#endif /* HOST_BENCH_H_ */
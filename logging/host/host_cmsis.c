@@ -0,0 +1,72 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+/* CMSIS core stand-ins of the Linux host build, see cmsis/host_device.h */
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <RTE_Components.h>
+#include CMSIS_device_header
+
+/* HP core clock, the cycle counts of the host build are in these units */
+uint32_t SystemCoreClock = 400000000;
+
+__thread uint32_t host_ipsr;
+__thread uint32_t host_primask;
+
+DCB_Type host_dcb;
+SysTick_Type host_systick;
+SCB_Type host_scb;
+
+/* Heap limit of the linker scripts, for the _sbrk of retarget.c */
+char __HeapLimit;
+
+static __thread DWT_Type host_dwt_regs;
+static pthread_mutex_t irq_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+uint32_t GetSystemCoreClock(void)
+{
+    return SystemCoreClock;
+}
+
+void host_irq_lock(void)
+{
+    pthread_mutex_lock(&irq_lock);
+}
+
+void host_irq_unlock(void)
+{
+    pthread_mutex_unlock(&irq_lock);
+}
+
+void host_wfe(void)
+{
+    sched_yield();
+}
+
+void host_breakpoint(uint32_t value)
+{
+    (void)value;
+    abort();
+}
+
+DWT_Type *host_dwt(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    const uint64_t ns = (uint64_t)now.tv_sec * 1000000000U + (uint64_t)now.tv_nsec;
+    host_dwt_regs.CYCCNT = (uint32_t)(ns * (SystemCoreClock / 1000000U) / 1000U);
+    return &host_dwt_regs;
+}
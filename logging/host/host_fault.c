@@ -0,0 +1,41 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+/*
+ * Fault handler stand-in of the Linux host build. host_fault_enter puts the
+ * calling thread into the state of a fault handler: in_fault_handler() is
+ * true and interrupts are masked for good, like the fault priority does.
+ */
+
+#include <stdbool.h>
+
+#include <RTE_Components.h>
+#include CMSIS_device_header
+
+#include "fault_handler.h"
+#include "host_fault.h"
+
+static volatile bool fault_active;
+
+void fault_dump_enable(bool enable)
+{
+    (void)enable;
+}
+
+bool in_fault_handler(void)
+{
+    return fault_active;
+}
+
+void host_fault_enter(void)
+{
+    __disable_irq();
+    fault_active = true;
+}
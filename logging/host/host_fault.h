@@ -0,0 +1,28 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+#ifndef HOST_FAULT_H_
+#define HOST_FAULT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Act as a fault handler from now on, see host_fault.c. Does not return
+ *        to normal operation, the test process has to end afterwards.
+ */
+void host_fault_enter(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_FAULT_H_ */
@@ -0,0 +1,133 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <RTE_Components.h>
+#include CMSIS_device_header
+
+#include "host_itm.h"
+
+#define IDLE_U8     0xFFU
+#define IDLE_U16    0xFFFFU
+#define IDLE_U32    0xFFFFFFFFU
+
+typedef struct {
+    char *data;
+    uint32_t len;
+    uint32_t size;
+} itm_output_t;
+
+static pthread_mutex_t itm_lock = PTHREAD_MUTEX_INITIALIZER;
+static ITM_Type itm_regs;
+static bool itm_armed;
+static uint32_t itm_stall;
+static bool itm_full;
+static itm_output_t itm_out[HOST_ITM_PORTS];
+static host_itm_stats_t itm_stats;
+
+static void output_put(uint32_t port, const void *data, uint32_t len)
+{
+    itm_output_t *out = &itm_out[port];
+
+    if (out->len + len + 1 > out->size) {
+        out->size = (out->len + len + 1) * 2;
+        out->data = realloc(out->data, out->size);
+    }
+    memcpy(out->data + out->len, data, len);
+    out->len += len;
+    out->data[out->len] = '\0';
+}
+
+/* Collect the writes since the previous access, little endian like the M55 */
+static void itm_collect(void)
+{
+    for (uint32_t port = 0; port < HOST_ITM_PORTS; port++) {
+        const uint8_t u8 = itm_regs.PORT[port].u8;
+        const uint16_t u16 = itm_regs.PORT[port].u16;
+        const uint32_t u32 = itm_regs.PORT[port].u32;
+        const uint32_t poll = itm_full ? 0U : IDLE_U32;
+        bool written = false;
+
+        if (u8 != IDLE_U8) {
+            output_put(port, &u8, 1);
+            written = true;
+        }
+        if (u16 != IDLE_U16) {
+            output_put(port, &u16, 2);
+            written = true;
+        }
+        if (u32 != poll) {
+            output_put(port, &u32, 4);
+            written = true;
+        }
+        if (written) {
+            itm_stats.writes++;
+            itm_stats.violations += itm_full;
+        }
+    }
+}
+
+ITM_Type *host_itm_regs(void)
+{
+    pthread_mutex_lock(&itm_lock);
+    if (itm_armed) {
+        itm_collect();
+    }
+    itm_full = itm_stall > 0;
+    if (itm_full) {
+        itm_stall--;
+        itm_stats.stalled++;
+    }
+    for (uint32_t port = 0; port < HOST_ITM_PORTS; port++) {
+        itm_regs.PORT[port].u8 = IDLE_U8;
+        itm_regs.PORT[port].u16 = IDLE_U16;
+        itm_regs.PORT[port].u32 = itm_full ? 0U : IDLE_U32;
+    }
+    itm_armed = true;
+    pthread_mutex_unlock(&itm_lock);
+    return &itm_regs;
+}
+
+void host_itm_stall(uint32_t polls)
+{
+    itm_stall = polls;
+}
+
+const char *host_itm_output(uint32_t port, uint32_t *len)
+{
+    // the last write has no access after it yet
+    (void)host_itm_regs();
+    if (len) {
+        *len = itm_out[port].len;
+    }
+    return itm_out[port].data ? itm_out[port].data : "";
+}
+
+void host_itm_clear(void)
+{
+    (void)host_itm_regs();
+    for (uint32_t port = 0; port < HOST_ITM_PORTS; port++) {
+        itm_out[port].len = 0;
+        if (itm_out[port].data) {
+            itm_out[port].data[0] = '\0';
+        }
+    }
+    memset(&itm_stats, 0, sizeof(itm_stats));
+}
+
+void host_itm_get_stats(host_itm_stats_t *stats)
+{
+    (void)host_itm_regs();
+    *stats = itm_stats;
+}
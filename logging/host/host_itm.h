@@ -0,0 +1,65 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+/*
+ * Register stand-in of the ITM stimulus ports for the Linux host build.
+ *
+ * Every ITM-> access goes through host_itm_regs(), which first collects what
+ * was written to the stimulus ports since the previous access and then arms
+ * them again with idle values: u32 reads 0xFFFFFFFF (ready, or 0 while the
+ * FIFO is stalled), u16 0xFFFF and u8 0xFF. A write is seen as a change of
+ * the idle value, so the stand-in only captures correctly when at most one
+ * write happens per access and the data never equals the idle value: text,
+ * not 0xFF bytes. Writing while the poll read 0 counts as a violation.
+ * One thread at a time may write to the ports.
+ */
+
+#ifndef HOST_ITM_H_
+#define HOST_ITM_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HOST_ITM_PORTS 32
+
+typedef struct {
+    uint32_t writes;        /* stimulus port writes of any size */
+    uint32_t stalled;       /* polls answered with a full FIFO */
+    uint32_t violations;    /* writes while the FIFO was full */
+} host_itm_stats_t;
+
+/**
+ * @brief Make the next reads polls of a full FIFO, the u32 port reads 0.
+ */
+void host_itm_stall(uint32_t polls);
+
+/**
+ * @brief Get the bytes written to a stimulus port, in order.
+ *
+ * @param len number of bytes, may be NULL
+ * @return the output, zero terminated
+ */
+const char *host_itm_output(uint32_t port, uint32_t *len);
+
+/**
+ * @brief Forget the output of all ports and reset the statistics.
+ */
+void host_itm_clear(void);
+
+void host_itm_get_stats(host_itm_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_ITM_H_ */
@@ -0,0 +1,47 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+/*
+ * Forced include of retarget.c in the Linux host build. The GNU retarget
+ * layer implements C library system calls, which must not replace the ones
+ * of the host C library, so they get a host_ prefix and are called directly
+ * by the tests and benchmarks instead.
+ */
+
+#ifndef HOST_RETARGET_H_
+#define HOST_RETARGET_H_
+
+#define _open           host_open
+#define _close          host_close
+#define _lseek          host_lseek
+#define _isatty         host_isatty
+#define _tmpnam         host_tmpnam
+#define _read           host_read
+#define _write          host_write
+#define _exit           host_exit
+#define _fstat          host_fstat
+#define _getpid         host_getpid
+#define _kill           host_kill
+#define _sbrk           host_sbrk
+#define _clock_init     host_clock_init
+#define system          host_system
+#define time            host_time
+#define clock           host_clock
+#define remove          host_remove
+#define rename          host_rename
+#define ferror          host_ferror
+#define clk_init        host_clk_init
+#define clk_uninit      host_clk_uninit
+#define SysTick_Handler host_SysTick_Handler
+
+int host_write(int fh, const unsigned char *buf, unsigned int len, int mode);
+int host_read(int fh, unsigned char *buf, unsigned int len, int mode);
+
+#endif /* HOST_RETARGET_H_ */
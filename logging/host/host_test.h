@@ -0,0 +1,67 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+/*
+ * Checks for the host unit tests. A failed check is reported and the test
+ * continues, main returns host_test_result().
+ */
+
+#ifndef HOST_TEST_H_
+#define HOST_TEST_H_
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+static int host_test_failures;
+
+#define CHECK(cond)                                                                 \
+    do {                                                                            \
+        if (!(cond)) {                                                              \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);         \
+            host_test_failures++;                                                   \
+        }                                                                           \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                                  \
+    do {                                                                            \
+        const long long actual_ = (long long)(actual);                              \
+        const long long expected_ = (long long)(expected);                          \
+        if (actual_ != expected_) {                                                 \
+            printf("%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__,        \
+                   #actual, actual_, expected_);                                    \
+            host_test_failures++;                                                   \
+        }                                                                           \
+    } while (0)
+
+#define CHECK_STR(actual, expected)                                                 \
+    do {                                                                            \
+        const char *actual_ = (actual);                                             \
+        const char *expected_ = (expected);                                         \
+        if (strcmp(actual_, expected_) != 0) {                                      \
+            printf("%s:%d: %s is \"%s\", expected \"%s\"\n", __FILE__, __LINE__,    \
+                   #actual, actual_, expected_);                                    \
+            host_test_failures++;                                                   \
+        }                                                                           \
+    } while (0)
+
+#define RUN_TEST(test)                                                              \
+    do {                                                                            \
+        const int before_ = host_test_failures;                                     \
+        test();                                                                     \
+        printf("%s %s\n", host_test_failures == before_ ? "PASS" : "FAIL", #test);  \
+    } while (0)
+
+static inline int host_test_result(void)
+{
+    return host_test_failures ? 1 : 0;
+}
+
+#endif /* HOST_TEST_H_ */
@@ -0,0 +1,566 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <RTE_Components.h>
+#include CMSIS_device_header
+
+#include "host_usart.h"
+
+#define RX_FIFO_SIZE 4096
+
+typedef struct {
+    uint32_t index;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool thread_started;
+    ARM_USART_SignalEvent_t cb_event;
+
+    bool powered;
+    bool tx_enabled;
+    bool rx_enabled;
+    uint32_t baudrate;
+    uint32_t speedup;
+
+    /* Ongoing Send */
+    bool tx_active;
+    const uint8_t *tx_data;
+    uint32_t tx_num;
+    uint32_t tx_count;
+    uint64_t tx_start_ns;
+    uint64_t tx_char_ns;
+
+    /* Ongoing Receive, fed from the receive FIFO */
+    bool rx_active;
+    uint8_t *rx_data;
+    uint32_t rx_num;
+    uint32_t rx_count;
+    uint8_t rx_fifo[RX_FIFO_SIZE];
+    uint32_t rx_head;
+    uint32_t rx_tail;
+    uint32_t events;                /* events waiting for the event thread */
+
+    bool capture;
+    bool loopback;
+    char *out;
+    uint32_t out_len;
+    uint32_t out_size;
+    host_usart_peer_t peer;
+    void *peer_ctx;
+    uint8_t *peer_buf;              /* bytes waiting to be handed to the peer */
+    uint32_t peer_len;
+    uint32_t peer_size;
+
+    host_usart_stats_t stats;
+} host_usart_t;
+
+static host_usart_t usarts[HOST_USART_COUNT];
+static pthread_once_t usarts_once = PTHREAD_ONCE_INIT;
+
+static void usarts_init(void)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+
+    for (uint32_t i = 0; i < HOST_USART_COUNT; i++) {
+        host_usart_t *u = &usarts[i];
+        u->index = i;
+        u->baudrate = 115200;
+        u->speedup = 1;
+        u->capture = true;
+        pthread_mutex_init(&u->lock, NULL);
+        pthread_cond_init(&u->cond, &attr);
+    }
+    pthread_condattr_destroy(&attr);
+}
+
+static host_usart_t *usart_get(uint32_t instance)
+{
+    pthread_once(&usarts_once, usarts_init);
+    return instance < HOST_USART_COUNT ? &usarts[instance] : NULL;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000U + (uint64_t)now.tv_nsec;
+}
+
+/* Characters on the wire so far, called with the lock held */
+static uint32_t tx_progress(const host_usart_t *u)
+{
+    if (!u->tx_active) {
+        return u->tx_count;
+    }
+    if (u->tx_char_ns == 0) {
+        return u->tx_num;
+    }
+    const uint64_t sent = (now_ns() - u->tx_start_ns) / u->tx_char_ns;
+    return sent < u->tx_num ? (uint32_t)sent : u->tx_num;
+}
+
+static void rx_push(host_usart_t *u, const uint8_t *data, uint32_t len)
+{
+    for (uint32_t i = 0; i < len; i++) {
+        if (u->rx_head - u->rx_tail == RX_FIFO_SIZE) {
+            u->events |= ARM_USART_EVENT_RX_OVERFLOW;
+            return;
+        }
+        u->rx_fifo[u->rx_head++ % RX_FIFO_SIZE] = data[i];
+    }
+}
+
+/* Put the first len bytes of the ongoing Send on the wire, called with the lock held */
+static void tx_deliver(host_usart_t *u, uint32_t len)
+{
+    if (u->capture && len) {
+        if (u->out_len + len + 1 > u->out_size) {
+            u->out_size = (u->out_len + len + 1) * 2;
+            u->out = realloc(u->out, u->out_size);
+        }
+        memcpy(u->out + u->out_len, u->tx_data, len);
+        u->out_len += len;
+        u->out[u->out_len] = '\0';
+    }
+    if (u->peer && len) {
+        if (u->peer_len + len > u->peer_size) {
+            u->peer_size = (u->peer_len + len) * 2;
+            u->peer_buf = realloc(u->peer_buf, u->peer_size);
+        }
+        memcpy(u->peer_buf + u->peer_len, u->tx_data, len);
+        u->peer_len += len;
+    }
+    if (u->loopback) {
+        rx_push(u, u->tx_data, len);
+    }
+    u->stats.tx_bytes += len;
+    u->stats.busy_ns += (uint64_t)len * u->tx_char_ns;
+}
+
+/*
+ * Finish the ongoing Send once its wire time is over, whoever looks first.
+ * The transmitter does not need the interrupt handler for that, only the
+ * event is left to the event thread. Called with the lock held, returns
+ * the characters on the wire so far.
+ */
+static uint32_t tx_update(host_usart_t *u)
+{
+    const uint32_t sent = tx_progress(u);
+
+    if (u->tx_active && sent == u->tx_num) {
+        tx_deliver(u, u->tx_num);
+        u->tx_count = u->tx_num;
+        u->tx_active = false;
+        u->events |= ARM_USART_EVENT_SEND_COMPLETE | ARM_USART_EVENT_TX_COMPLETE;
+        pthread_cond_broadcast(&u->cond);
+    }
+    return sent;
+}
+
+static void tx_stop(host_usart_t *u)
+{
+    if (u->tx_active) {
+        const uint32_t sent = tx_progress(u);
+        tx_deliver(u, sent);
+        u->tx_active = false;
+        u->tx_count = sent;
+        pthread_cond_broadcast(&u->cond);
+    }
+}
+
+/*
+ * Event thread of an instance, completes transfers and signals the events
+ * like the USART interrupt handler.
+ */
+static void *usart_thread(void *arg)
+{
+    host_usart_t *u = arg;
+    uint8_t *wire = NULL;
+    uint32_t wire_size = 0;
+
+    pthread_mutex_lock(&u->lock);
+    for (;;) {
+        tx_update(u);
+
+        if (u->rx_active && u->rx_head != u->rx_tail) {
+            while (u->rx_count < u->rx_num && u->rx_head != u->rx_tail) {
+                u->rx_data[u->rx_count++] = u->rx_fifo[u->rx_tail++ % RX_FIFO_SIZE];
+                u->stats.rx_bytes++;
+            }
+            if (u->rx_count == u->rx_num) {
+                u->rx_active = false;
+                u->events |= ARM_USART_EVENT_RECEIVE_COMPLETE;
+            }
+        }
+
+        if (u->events == 0 && u->peer_len == 0) {
+            if (u->tx_active) {
+                const uint64_t end = u->tx_start_ns + (uint64_t)u->tx_num * u->tx_char_ns;
+                struct timespec deadline = { .tv_sec = end / 1000000000U, .tv_nsec = end % 1000000000U };
+                pthread_cond_timedwait(&u->cond, &u->lock, &deadline);
+            } else {
+                pthread_cond_wait(&u->cond, &u->lock);
+            }
+            continue;
+        }
+
+        const uint32_t events = u->events;
+        const uint32_t wire_len = u->peer_len;
+        if (wire_len > wire_size) {
+            wire_size = wire_len;
+            wire = realloc(wire, wire_size);
+        }
+        if (wire_len) {
+            memcpy(wire, u->peer_buf, wire_len);
+        }
+        u->events = 0;
+        u->peer_len = 0;
+
+        const ARM_USART_SignalEvent_t cb_event = u->cb_event;
+        const host_usart_peer_t peer = u->peer;
+        void *peer_ctx = u->peer_ctx;
+        const uint32_t baudrate = u->baudrate;
+        pthread_mutex_unlock(&u->lock);
+
+        if (wire_len && peer) {
+            peer(u->index, wire, wire_len, baudrate, peer_ctx);
+        }
+        if (events && cb_event) {
+            host_irq_lock();
+            host_ipsr = HOST_USART_IRQn + u->index;
+            cb_event(events);
+            host_ipsr = 0;
+            host_irq_unlock();
+        }
+        pthread_mutex_lock(&u->lock);
+    }
+    return NULL;
+}
+
+static int32_t usart_initialize(host_usart_t *u, ARM_USART_SignalEvent_t cb_event)
+{
+    pthread_mutex_lock(&u->lock);
+    u->cb_event = cb_event;
+    if (!u->thread_started) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, usart_thread, u) != 0) {
+            pthread_mutex_unlock(&u->lock);
+            return ARM_DRIVER_ERROR;
+        }
+        pthread_detach(thread);
+        u->thread_started = true;
+    }
+    pthread_mutex_unlock(&u->lock);
+    return ARM_DRIVER_OK;
+}
+
+static int32_t usart_uninitialize(host_usart_t *u)
+{
+    pthread_mutex_lock(&u->lock);
+    tx_stop(u);
+    u->rx_active = false;
+    u->cb_event = NULL;
+    pthread_mutex_unlock(&u->lock);
+    return ARM_DRIVER_OK;
+}
+
+static int32_t usart_power_control(host_usart_t *u, ARM_POWER_STATE state)
+{
+    pthread_mutex_lock(&u->lock);
+    if (state == ARM_POWER_FULL) {
+        u->powered = true;
+    } else {
+        tx_stop(u);
+        u->rx_active = false;
+        u->powered = false;
+    }
+    pthread_mutex_unlock(&u->lock);
+    return ARM_DRIVER_OK;
+}
+
+static int32_t usart_send(host_usart_t *u, const void *data, uint32_t num)
+{
+    int32_t ret = ARM_DRIVER_OK;
+
+    if (data == NULL || num == 0) {
+        return ARM_DRIVER_ERROR_PARAMETER;
+    }
+    pthread_mutex_lock(&u->lock);
+    tx_update(u);
+    if (!u->powered || !u->tx_enabled || u->baudrate == 0) {
+        ret = ARM_DRIVER_ERROR;
+    } else if (u->tx_active) {
+        u->stats.busy++;
+        ret = ARM_DRIVER_ERROR_BUSY;
+    } else {
+        u->tx_active = true;
+        u->tx_data = data;
+        u->tx_num = num;
+        u->tx_count = 0;
+        u->tx_char_ns = u->speedup ? 10000000000ULL / u->baudrate / u->speedup : 0;
+        u->tx_start_ns = now_ns();
+        u->stats.sends++;
+        pthread_cond_broadcast(&u->cond);
+    }
+    pthread_mutex_unlock(&u->lock);
+    return ret;
+}
+
+static int32_t usart_receive(host_usart_t *u, void *data, uint32_t num)
+{
+    int32_t ret = ARM_DRIVER_OK;
+
+    if (data == NULL || num == 0) {
+        return ARM_DRIVER_ERROR_PARAMETER;
+    }
+    pthread_mutex_lock(&u->lock);
+    if (!u->powered || !u->rx_enabled) {
+        ret = ARM_DRIVER_ERROR;
+    } else if (u->rx_active) {
+        ret = ARM_DRIVER_ERROR_BUSY;
+    } else {
+        u->rx_active = true;
+        u->rx_data = data;
+        u->rx_num = num;
+        u->rx_count = 0;
+        pthread_cond_broadcast(&u->cond);
+    }
+    pthread_mutex_unlock(&u->lock);
+    return ret;
+}
+
+static uint32_t usart_get_tx_count(host_usart_t *u)
+{
+    pthread_mutex_lock(&u->lock);
+    const uint32_t count = tx_update(u);
+    pthread_mutex_unlock(&u->lock);
+    return count;
+}
+
+static uint32_t usart_get_rx_count(host_usart_t *u)
+{
+    pthread_mutex_lock(&u->lock);
+    const uint32_t count = u->rx_count;
+    pthread_mutex_unlock(&u->lock);
+    return count;
+}
+
+static int32_t usart_control(host_usart_t *u, uint32_t control, uint32_t arg)
+{
+    int32_t ret = ARM_DRIVER_OK;
+
+    pthread_mutex_lock(&u->lock);
+    switch (control & ARM_USART_CONTROL_Msk) {
+    case ARM_USART_MODE_ASYNCHRONOUS:
+        if (arg == 0) {
+            ret = ARM_DRIVER_ERROR_PARAMETER;
+        } else {
+            u->baudrate = arg;
+        }
+        break;
+    case ARM_USART_CONTROL_TX:
+        u->tx_enabled = arg != 0;
+        break;
+    case ARM_USART_CONTROL_RX:
+        u->rx_enabled = arg != 0;
+        break;
+    case ARM_USART_ABORT_SEND:
+        tx_stop(u);
+        break;
+    case ARM_USART_ABORT_RECEIVE:
+        u->rx_active = false;
+        break;
+    default:
+        ret = ARM_DRIVER_ERROR_UNSUPPORTED;
+        break;
+    }
+    pthread_mutex_unlock(&u->lock);
+    return ret;
+}
+
+static ARM_USART_STATUS usart_get_status(host_usart_t *u)
+{
+    ARM_USART_STATUS status = { 0 };
+
+    pthread_mutex_lock(&u->lock);
+    tx_update(u);
+    status.tx_busy = u->tx_active;
+    status.rx_busy = u->rx_active;
+    pthread_mutex_unlock(&u->lock);
+    return status;
+}
+
+static ARM_DRIVER_VERSION usart_get_version(void)
+{
+    return (ARM_DRIVER_VERSION) { ARM_DRIVER_VERSION_MAJOR_MINOR(2, 3), ARM_DRIVER_VERSION_MAJOR_MINOR(1, 0) };
+}
+
+static ARM_USART_CAPABILITIES usart_get_capabilities(void)
+{
+    return (ARM_USART_CAPABILITIES) { .asynchronous = 1 };
+}
+
+static int32_t usart_transfer(const void *data_out, void *data_in, uint32_t num)
+{
+    (void)data_out;
+    (void)data_in;
+    (void)num;
+    return ARM_DRIVER_ERROR_UNSUPPORTED;
+}
+
+static int32_t usart_set_modem_control(ARM_USART_MODEM_CONTROL control)
+{
+    (void)control;
+    return ARM_DRIVER_ERROR_UNSUPPORTED;
+}
+
+static ARM_USART_MODEM_STATUS usart_get_modem_status(void)
+{
+    return (ARM_USART_MODEM_STATUS) { 0 };
+}
+
+/* CMSIS driver functions take no instance, every instance gets its own set */
+#define HOST_USART_DRIVER(n)                                                                        \
+    static int32_t usart##n##_initialize(ARM_USART_SignalEvent_t cb)                                \
+        { return usart_initialize(usart_get(n), cb); }                                              \
+    static int32_t usart##n##_uninitialize(void) { return usart_uninitialize(usart_get(n)); }       \
+    static int32_t usart##n##_power_control(ARM_POWER_STATE state)                                  \
+        { return usart_power_control(usart_get(n), state); }                                        \
+    static int32_t usart##n##_send(const void *data, uint32_t num)                                  \
+        { return usart_send(usart_get(n), data, num); }                                             \
+    static int32_t usart##n##_receive(void *data, uint32_t num)                                     \
+        { return usart_receive(usart_get(n), data, num); }                                          \
+    static uint32_t usart##n##_get_tx_count(void) { return usart_get_tx_count(usart_get(n)); }      \
+    static uint32_t usart##n##_get_rx_count(void) { return usart_get_rx_count(usart_get(n)); }      \
+    static int32_t usart##n##_control(uint32_t control, uint32_t arg)                               \
+        { return usart_control(usart_get(n), control, arg); }                                       \
+    static ARM_USART_STATUS usart##n##_get_status(void) { return usart_get_status(usart_get(n)); }  \
+    ARM_DRIVER_USART Driver_USART##n = {                                                            \
+        usart_get_version,                                                                          \
+        usart_get_capabilities,                                                                     \
+        usart##n##_initialize,                                                                      \
+        usart##n##_uninitialize,                                                                    \
+        usart##n##_power_control,                                                                   \
+        usart##n##_send,                                                                            \
+        usart##n##_receive,                                                                         \
+        usart_transfer,                                                                             \
+        usart##n##_get_tx_count,                                                                    \
+        usart##n##_get_rx_count,                                                                    \
+        usart##n##_control,                                                                         \
+        usart##n##_get_status,                                                                      \
+        usart_set_modem_control,                                                                    \
+        usart_get_modem_status                                                                      \
+    }
+
+HOST_USART_DRIVER(0);
+HOST_USART_DRIVER(1);
+HOST_USART_DRIVER(2);
+HOST_USART_DRIVER(3);
+
+void host_usart_set_speedup(uint32_t instance, uint32_t speedup)
+{
+    host_usart_t *u = usart_get(instance);
+    pthread_mutex_lock(&u->lock);
+    u->speedup = speedup;
+    pthread_mutex_unlock(&u->lock);
+}
+
+void host_usart_set_capture(uint32_t instance, bool enable)
+{
+    host_usart_t *u = usart_get(instance);
+    pthread_mutex_lock(&u->lock);
+    u->capture = enable;
+    pthread_mutex_unlock(&u->lock);
+}
+
+void host_usart_set_loopback(uint32_t instance, bool enable)
+{
+    host_usart_t *u = usart_get(instance);
+    pthread_mutex_lock(&u->lock);
+    u->loopback = enable;
+    pthread_mutex_unlock(&u->lock);
+}
+
+void host_usart_set_peer(uint32_t instance, host_usart_peer_t peer, void *ctx)
+{
+    host_usart_t *u = usart_get(instance);
+    pthread_mutex_lock(&u->lock);
+    u->peer = peer;
+    u->peer_ctx = ctx;
+    pthread_mutex_unlock(&u->lock);
+}
+
+void host_usart_inject(uint32_t instance, const void *data, uint32_t len, uint32_t baudrate)
+{
+    host_usart_t *u = usart_get(instance);
+    pthread_mutex_lock(&u->lock);
+    if (baudrate != 0 && baudrate != u->baudrate) {
+        u->stats.rx_errors += len;
+        u->events |= ARM_USART_EVENT_RX_FRAMING_ERROR;
+    } else {
+        rx_push(u, data, len);
+    }
+    pthread_cond_broadcast(&u->cond);
+    pthread_mutex_unlock(&u->lock);
+}
+
+const char *host_usart_output(uint32_t instance, uint32_t *len)
+{
+    host_usart_t *u = usart_get(instance);
+    pthread_mutex_lock(&u->lock);
+    const char *out = u->out ? u->out : "";
+    if (len) {
+        *len = u->out_len;
+    }
+    pthread_mutex_unlock(&u->lock);
+    return out;
+}
+
+void host_usart_clear_output(uint32_t instance)
+{
+    host_usart_t *u = usart_get(instance);
+    pthread_mutex_lock(&u->lock);
+    u->out_len = 0;
+    if (u->out) {
+        u->out[0] = '\0';
+    }
+    pthread_mutex_unlock(&u->lock);
+}
+
+uint32_t host_usart_get_baudrate(uint32_t instance)
+{
+    host_usart_t *u = usart_get(instance);
+    pthread_mutex_lock(&u->lock);
+    const uint32_t baudrate = u->baudrate;
+    pthread_mutex_unlock(&u->lock);
+    return baudrate;
+}
+
+void host_usart_get_stats(uint32_t instance, host_usart_stats_t *stats)
+{
+    host_usart_t *u = usart_get(instance);
+    pthread_mutex_lock(&u->lock);
+    *stats = u->stats;
+    pthread_mutex_unlock(&u->lock);
+}
+
+void host_usart_reset_stats(uint32_t instance)
+{
+    host_usart_t *u = usart_get(instance);
+    pthread_mutex_lock(&u->lock);
+    memset(&u->stats, 0, sizeof(u->stats));
+    pthread_mutex_unlock(&u->lock);
+}
@@ -0,0 +1,119 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+/*
+ * Stand-in CMSIS USART drivers of the Linux host build, Driver_USART0 to
+ * Driver_USART3.
+ *
+ * Send takes as long as the characters need on the wire at the configured
+ * baud rate (10 bits each) and GetTxCount follows the progress. The data is
+ * read from the caller's buffer when the last character has gone out, then
+ * ARM_USART_EVENT_SEND_COMPLETE is signalled from the driver's event thread,
+ * which acts as the USART interrupt: IPSR is set and masked interrupts hold
+ * it off. Received bytes come from host_usart_inject or the loopback and
+ * complete a Receive one event at a time.
+ *
+ * The transmitted bytes are kept for the test (host_usart_output) and handed
+ * to an optional peer, which stands in for the host end of the cable.
+ */
+
+#ifndef HOST_USART_H_
+#define HOST_USART_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "Driver_USART.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HOST_USART_COUNT 4
+
+extern ARM_DRIVER_USART Driver_USART0;
+extern ARM_DRIVER_USART Driver_USART1;
+extern ARM_DRIVER_USART Driver_USART2;
+extern ARM_DRIVER_USART Driver_USART3;
+
+/**
+ * @brief Receives the bytes the driver has put on the wire, called from the
+ *        event thread (not in interrupt context) at the end of every Send.
+ *
+ * @param baudrate rate the bytes were sent at
+ */
+typedef void (*host_usart_peer_t)(uint32_t instance, const uint8_t *data, uint32_t len,
+                                  uint32_t baudrate, void *ctx);
+
+typedef struct {
+    uint32_t sends;         /* Send calls accepted */
+    uint32_t busy;          /* Send calls rejected while a transmission was ongoing */
+    uint64_t tx_bytes;      /* bytes put on the wire */
+    uint64_t rx_bytes;      /* bytes handed to Receive */
+    uint32_t rx_errors;     /* injected bytes lost to a baud rate mismatch */
+    uint64_t busy_ns;       /* time the transmitter was busy */
+} host_usart_stats_t;
+
+/**
+ * @brief Scale the wire time, e.g. 10 runs the transmission 10 times faster
+ *        than the baud rate. 0 completes every Send without wire time.
+ */
+void host_usart_set_speedup(uint32_t instance, uint32_t speedup);
+
+/**
+ * @brief Keep the transmitted bytes for host_usart_output, on by default.
+ */
+void host_usart_set_capture(uint32_t instance, bool enable);
+
+/**
+ * @brief Feed the transmitted bytes back into the receiver.
+ */
+void host_usart_set_loopback(uint32_t instance, bool enable);
+
+/**
+ * @brief Set the host end of the cable, NULL removes it.
+ */
+void host_usart_set_peer(uint32_t instance, host_usart_peer_t peer, void *ctx);
+
+/**
+ * @brief Put bytes on the receive line.
+ *
+ * @param baudrate rate the bytes are sent at, the bytes are lost with an
+ *                 ARM_USART_EVENT_RX_FRAMING_ERROR if it differs from the
+ *                 driver's rate. 0 always matches.
+ */
+void host_usart_inject(uint32_t instance, const void *data, uint32_t len, uint32_t baudrate);
+
+/**
+ * @brief Get the captured output, zero terminated.
+ *
+ * @param len number of bytes captured, may be NULL
+ * @return the output, valid until the driver sends again
+ */
+const char *host_usart_output(uint32_t instance, uint32_t *len);
+
+/**
+ * @brief Forget the captured output.
+ */
+void host_usart_clear_output(uint32_t instance);
+
+/**
+ * @brief Get the baud rate the driver is configured for.
+ */
+uint32_t host_usart_get_baudrate(uint32_t instance);
+
+void host_usart_get_stats(uint32_t instance, host_usart_stats_t *stats);
+void host_usart_reset_stats(uint32_t instance);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_USART_H_ */
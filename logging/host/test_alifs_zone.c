@@ -0,0 +1,140 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+/*
+ * Profiling zones: statistics, the zone and global switches and the "zones"
+ * shell command.
+ */
+
+#include "alifs_zone.h"
+#include "host_test.h"
+#include "host_usart.h"
+#include "uart_tracelib.h"
+
+#define UART 2
+
+ALIFS_ZONE_DEFINE(zone_first, "first");
+ALIFS_ZONE_DEFINE(zone_second, "second");
+
+static void measure(void)
+{
+    ALIFS_ZONE_BEGIN(zone_first);
+    ALIFS_ZONE_BEGIN(zone_second);
+    ALIFS_ZONE_END(zone_second);
+    ALIFS_ZONE_END(zone_first);
+}
+
+static uint32_t count(const alifs_zone_t *zone)
+{
+    alifs_zone_stats_t stats;
+    alifs_zone_get_stats(zone, &stats);
+    return stats.count;
+}
+
+static const char *shell(const char *command)
+{
+    char line[64];
+
+    tracelib_flush();
+    host_usart_clear_output(UART);
+    strcpy(line, command);
+    tracelib_shell_execute(line);
+    tracelib_flush();
+    return host_usart_output(UART, NULL);
+}
+
+static void test_section(void)
+{
+    CHECK_EQ(alifs_zone_count(), 2);
+    CHECK(alifs_zone_find("first") == &zone_first);
+    CHECK(alifs_zone_find("second") == &zone_second);
+    CHECK(alifs_zone_find("third") == NULL);
+}
+
+static void test_stats(void)
+{
+    alifs_zone_stats_t stats;
+
+    alifs_zone_reset(NULL);
+    alifs_zone_record(&zone_first, 10);
+    alifs_zone_record(&zone_first, 30);
+    alifs_zone_record(&zone_first, 20);
+    alifs_zone_get_stats(&zone_first, &stats);
+    CHECK_EQ(stats.count, 3);
+    CHECK_EQ(stats.min, 10);
+    CHECK_EQ(stats.max, 30);
+    CHECK_EQ(stats.last, 20);
+    CHECK_EQ(stats.sum, 60);
+    CHECK(stats.sum_sq == 1400.0);
+}
+
+static void test_enable(void)
+{
+    alifs_zone_reset(NULL);
+    measure();
+    CHECK_EQ(count(&zone_first), 1);
+    CHECK_EQ(count(&zone_second), 1);
+
+    alifs_zone_enable(&zone_second, false);
+    measure();
+    CHECK_EQ(count(&zone_first), 2);
+    CHECK_EQ(count(&zone_second), 1);
+
+    // all zones off, the zone switches are kept
+    alifs_zone_enable(NULL, false);
+    measure();
+    CHECK_EQ(count(&zone_first), 2);
+    alifs_zone_enable(NULL, true);
+    measure();
+    CHECK_EQ(count(&zone_first), 3);
+    CHECK_EQ(count(&zone_second), 1);
+
+    alifs_zone_enable(&zone_second, true);
+    measure();
+    CHECK_EQ(count(&zone_second), 2);
+}
+
+static void test_shell(void)
+{
+    CHECK_EQ(tracelib_zone_shell_register(), 0);
+    alifs_zone_reset(NULL);
+
+    shell("zones off second");
+    CHECK(!alifs_zone_enabled(&zone_second));
+    measure();
+    CHECK_EQ(count(&zone_second), 0);
+    CHECK(strstr(shell("zones"), "second 0 (off)\n") != NULL);
+
+    shell("zones off");
+    CHECK(!alifs_zone_enabled(&zone_first));
+    CHECK(strstr(shell("zones"), "zones off\n") != NULL);
+    shell("zones on");
+    shell("zones on second");
+    CHECK(alifs_zone_enabled(&zone_first));
+    CHECK(alifs_zone_enabled(&zone_second));
+
+    measure();
+    shell("zones reset first");
+    CHECK_EQ(count(&zone_first), 0);
+    CHECK_EQ(count(&zone_second), 1);
+    CHECK(strstr(shell("zones off third"), "unknown zone third\n") != NULL);
+}
+
+int main(void)
+{
+    CHECK_EQ(tracelib_init("", NULL), 0);
+    host_usart_set_speedup(UART, 0);
+
+    RUN_TEST(test_section);
+    RUN_TEST(test_stats);
+    RUN_TEST(test_enable);
+    RUN_TEST(test_shell);
+    return host_test_result();
+}
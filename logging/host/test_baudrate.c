@@ -0,0 +1,187 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+/*
+ * Baud rate handshake of tracelib_set_baudrate against a peer on the
+ * stand-in UART that answers like logging/analyser/trace_capture.py, and
+ * against a missing host and a loopback cable.
+ */
+
+#include <stdlib.h>
+
+#include "host_test.h"
+#include "host_usart.h"
+#include "uart_tracelib.h"
+
+#define UART 2
+#define TIMEOUT_MS 100
+
+typedef enum {
+    HOST_CAPTURE,       /* answers like trace_capture.py */
+    HOST_NO_SYNC,       /* accepts the rate but never echoes the sync line */
+} host_mode_t;
+
+/* Host end of the cable, runs on the driver's event thread */
+typedef struct {
+    host_mode_t mode;
+    uint32_t max_baudrate;
+    uint32_t baudrate;          /* rate the host port is set to */
+    uint32_t previous;          /* rate to return to without a sync line */
+    bool switching;
+    uint32_t switches;
+    uint32_t garbage;           /* bytes received at the wrong rate */
+    char pending[256];
+    uint32_t pending_len;
+    char text[4096];            /* everything received at the right rate */
+    uint32_t text_len;
+} host_t;
+
+static host_t host;
+
+static void host_reset(host_mode_t mode)
+{
+    memset(&host, 0, sizeof(host));
+    host.mode = mode;
+    host.max_baudrate = 3000000;
+    host.baudrate = host_usart_get_baudrate(UART);
+}
+
+static void host_answer(const char *line)
+{
+    host_usart_inject(UART, line, strlen(line), host.baudrate);
+}
+
+static void host_receive(uint32_t instance, const uint8_t *data, uint32_t len, uint32_t baudrate,
+                         void *ctx)
+{
+    (void)instance;
+    (void)ctx;
+
+    if (baudrate != host.baudrate) {
+        host.garbage += len;
+        return;
+    }
+    if (host.text_len + len < sizeof(host.text)) {
+        memcpy(host.text + host.text_len, data, len);
+        host.text_len += len;
+        host.text[host.text_len] = '\0';
+    }
+    if (host.pending_len + len >= sizeof(host.pending)) {
+        host.pending_len = 0;
+    }
+    memcpy(host.pending + host.pending_len, data, len);
+    host.pending_len += len;
+    host.pending[host.pending_len] = '\0';
+
+    if (host.switching) {
+        if (strstr(host.pending, TRACELIB_BAUD_SYNC "\n")) {
+            host.switching = false;
+            host.switches++;
+            host.pending_len = 0;
+            if (host.mode == HOST_CAPTURE) {
+                host_answer(TRACELIB_BAUD_SYNC "\n");
+            }
+        }
+        return;
+    }
+
+    const char *request = strstr(host.pending, TRACELIB_BAUD_REQUEST);
+    unsigned long rate;
+    char end;
+    if (request && sscanf(request + strlen(TRACELIB_BAUD_REQUEST), "%lu%c", &rate, &end) == 2 &&
+        end == '\n') {
+        host.pending_len = 0;
+        if (rate > host.max_baudrate) {
+            host_answer(TRACELIB_BAUD_REJECT "\n");
+            return;
+        }
+        host_answer(TRACELIB_BAUD_ACCEPT "\n");
+        host.previous = host.baudrate;
+        host.baudrate = rate;
+        host.switching = true;
+    }
+}
+
+static void test_accept(void)
+{
+    host_reset(HOST_CAPTURE);
+    host_usart_set_peer(UART, host_receive, NULL);
+
+    CHECK_EQ(tracelib_set_baudrate(921600, TIMEOUT_MS), ARM_DRIVER_OK);
+    CHECK_EQ(tracelib_get_baudrate(), 921600);
+    CHECK_EQ(host_usart_get_baudrate(UART), 921600);
+    CHECK_EQ(host.switches, 1);
+
+    // the output continues at the new rate
+    host.text_len = 0;
+    tracef("fast\n");
+    tracelib_flush();
+    CHECK(strstr(host.text, "[T] fast\n") != NULL);
+
+    CHECK_EQ(tracelib_set_baudrate(115200, TIMEOUT_MS), ARM_DRIVER_OK);
+    CHECK_EQ(host_usart_get_baudrate(UART), 115200);
+    CHECK_EQ(host.switches, 2);
+    host_usart_set_peer(UART, NULL, NULL);
+}
+
+static void test_reject(void)
+{
+    host_reset(HOST_CAPTURE);
+    host_usart_set_peer(UART, host_receive, NULL);
+
+    CHECK_EQ(tracelib_set_baudrate(4000000, TIMEOUT_MS), ARM_DRIVER_ERROR_UNSUPPORTED);
+    CHECK_EQ(tracelib_get_baudrate(), 115200);
+    CHECK_EQ(host_usart_get_baudrate(UART), 115200);
+    CHECK_EQ(host.garbage, 0);
+    host_usart_set_peer(UART, NULL, NULL);
+}
+
+static void test_no_host(void)
+{
+    CHECK_EQ(tracelib_set_baudrate(921600, TIMEOUT_MS), ARM_DRIVER_ERROR_TIMEOUT);
+    CHECK_EQ(tracelib_get_baudrate(), 115200);
+    CHECK_EQ(host_usart_get_baudrate(UART), 115200);
+}
+
+static void test_no_sync(void)
+{
+    host_reset(HOST_NO_SYNC);
+    host_usart_set_peer(UART, host_receive, NULL);
+
+    // the sync line arrives but the echo never does, the target falls back
+    CHECK_EQ(tracelib_set_baudrate(921600, TIMEOUT_MS), ARM_DRIVER_ERROR_TIMEOUT);
+    CHECK_EQ(tracelib_get_baudrate(), 115200);
+    CHECK_EQ(host_usart_get_baudrate(UART), 115200);
+    CHECK_EQ(host.switches, 1);
+    host_usart_set_peer(UART, NULL, NULL);
+}
+
+static void test_loopback(void)
+{
+    // the target hears its own request, which is no answer
+    host_usart_set_loopback(UART, true);
+    CHECK_EQ(tracelib_set_baudrate(921600, TIMEOUT_MS), ARM_DRIVER_ERROR_TIMEOUT);
+    CHECK_EQ(tracelib_get_baudrate(), 115200);
+    CHECK_EQ(host_usart_get_baudrate(UART), 115200);
+    host_usart_set_loopback(UART, false);
+}
+
+int main(void)
+{
+    CHECK_EQ(tracelib_init("[T] ", NULL), 0);
+    host_usart_set_capture(UART, false);
+
+    RUN_TEST(test_accept);
+    RUN_TEST(test_reject);
+    RUN_TEST(test_no_host);
+    RUN_TEST(test_no_sync);
+    RUN_TEST(test_loopback);
+    return host_test_result();
+}
@@ -0,0 +1,180 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+/*
+ * Encoding kernels of trace_encode.c on their portable path, checked
+ * against snprintf, and the fault dump lines built with them
+ * (fault_handler/fault_dump.c).
+ */
+
+#include <ctype.h>
+#include <stdlib.h>
+
+#include "fault_dump.h"
+#include "host_test.h"
+#include "host_usart.h"
+#include "trace_encode.h"
+#include "uart_tracelib.h"
+
+#define UART 2
+
+static void test_hex8(void)
+{
+    uint8_t bytes[64];
+    char expected[2 * sizeof(bytes) + 1];
+    char out[2 * sizeof(bytes) + 1];
+
+    for (uint32_t i = 0; i < sizeof(bytes); i++) {
+        bytes[i] = (uint8_t)(i * 37 + 11);
+    }
+    // lengths around the 16-byte blocks of the vector path
+    for (uint32_t len = 0; len <= sizeof(bytes); len++) {
+        for (uint32_t i = 0; i < len; i++) {
+            snprintf(&expected[i * 2], 3, "%02X", bytes[i]);
+        }
+        expected[len * 2] = '\0';
+        memset(out, '#', sizeof(out));
+        trace_encode_hex8(out, bytes, len);
+        CHECK_EQ(out[len * 2], '#');
+        out[len * 2] = '\0';
+        CHECK_STR(out, expected);
+    }
+}
+
+static void test_hex32(void)
+{
+    const uint32_t words[9] = {
+        0, 1, 0x89ABCDEF, 0xFFFFFFFF, 0x10000000, 0x0000FFFF, 0xDEADBEEF, 0x7FFFFFFF, 0x80000000
+    };
+    char expected[8 * 9 + 1];
+    char out[8 * 9 + 1];
+
+    for (uint32_t count = 0; count <= 9; count++) {
+        for (uint32_t i = 0; i < count; i++) {
+            snprintf(&expected[i * 8], 9, "%08X", words[i]);
+        }
+        expected[count * 8] = '\0';
+        memset(out, '#', sizeof(out));
+        trace_encode_hex32(out, words, count);
+        CHECK_EQ(out[count * 8], '#');
+        out[count * 8] = '\0';
+        CHECK_STR(out, expected);
+    }
+}
+
+static void test_dec32(void)
+{
+    static const uint32_t edges[] = {
+        0, 1, 9, 10, 99, 100, 101, 999, 1000, 65535, 99999999, 100000000, 999999999,
+        1000000000, 4294967295U
+    };
+    char expected[11];
+    char out[11];
+
+    for (uint32_t i = 0; i < sizeof(edges) / sizeof(edges[0]) + 10000; i++) {
+        const uint32_t value = i < sizeof(edges) / sizeof(edges[0]) ? edges[i] : (uint32_t)rand() * 2654435761U;
+        const int len = snprintf(expected, sizeof(expected), "%u", value);
+        CHECK_EQ(trace_encode_dec32(out, value), len);
+        out[len] = '\0';
+        CHECK_STR(out, expected);
+    }
+}
+
+static void test_ascii(void)
+{
+    uint8_t bytes[256];
+    char out[256];
+
+    for (uint32_t i = 0; i < sizeof(bytes); i++) {
+        bytes[i] = (uint8_t)i;
+    }
+    trace_encode_ascii(out, bytes, sizeof(bytes));
+    for (uint32_t i = 0; i < sizeof(bytes); i++) {
+        CHECK_EQ(out[i], isprint(i) ? (char)i : '.');
+    }
+}
+
+static const char *dump_output(void)
+{
+    tracelib_flush();
+    return host_usart_output(UART, NULL);
+}
+
+static void test_fault_registers(void)
+{
+    const uint32_t regs[6] = { 0, 0x1, 0x20000000, 0xDEADBEEF, 0x12345678, 0xFFFFFFFF };
+
+    host_usart_clear_output(UART);
+    fault_dump_registers(regs, 6);
+    CHECK_STR(dump_output(), "R0  = 00000000 R1  = 00000001 R2  = 20000000 R3  = DEADBEEF\n"
+                             "R4  = 12345678 R5  = FFFFFFFF ");
+
+    uint32_t many[13] = { 0 };
+    many[12] = 12;
+    host_usart_clear_output(UART);
+    fault_dump_registers(many, 13);
+    CHECK(strstr(dump_output(), "R11 = 00000000\nR12 = 0000000C ") != NULL);
+}
+
+static void test_fault_stack(void)
+{
+    uint32_t stack[12] __attribute__((aligned(16)));
+    char expected[512];
+    int len = 0;
+
+    for (uint32_t i = 0; i < 12; i++) {
+        stack[i] = 0x41424344U + i;
+    }
+    stack[2] = 0x00010203;
+
+    // starts a word into the first line, ends half way into the third
+    const uintptr_t sp = (uintptr_t)&stack[1];
+    const uintptr_t top = (uintptr_t)&stack[10];
+    const uint32_t base = (uint32_t)(uintptr_t)stack;
+    len += snprintf(expected + len, sizeof(expected) - len, "\n==== Stack dump ====\n\n"
+                    "Address  :     3 2 1 0     7 6 5 4     B A 9 8     F E D C       ASCII Data\n");
+    len += snprintf(expected + len, sizeof(expected) - len,
+                    "%08X :                41424345    00010203    41424347        ECBA....GCBA\n",
+                    base);
+    len += snprintf(expected + len, sizeof(expected) - len,
+                    "%08X :    41424348    41424349    4142434A    4142434B    HCBAICBAJCBAKCBA\n",
+                    base + 16);
+    len += snprintf(expected + len, sizeof(expected) - len,
+                    "%08X :    4142434C    4142434D                            LCBAMCBA        \n",
+                    base + 32);
+
+    host_usart_clear_output(UART);
+    fault_dump_stack(sp, top, 20);
+    CHECK_STR(dump_output(), expected);
+
+    // the line limit applies when the top is not known
+    host_usart_clear_output(UART);
+    fault_dump_stack(sp, UINTPTR_MAX, 2);
+    const char *out = dump_output();
+    uint32_t lines = 0;
+    for (; *out; out++) {
+        lines += *out == '\n';
+    }
+    CHECK_EQ(lines, 4 + 2);
+}
+
+int main(void)
+{
+    CHECK_EQ(tracelib_init("", NULL), 0);
+    host_usart_set_speedup(UART, 0);
+
+    RUN_TEST(test_hex8);
+    RUN_TEST(test_hex32);
+    RUN_TEST(test_dec32);
+    RUN_TEST(test_ascii);
+    RUN_TEST(test_fault_registers);
+    RUN_TEST(test_fault_stack);
+    return host_test_result();
+}
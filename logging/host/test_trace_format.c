@@ -0,0 +1,174 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+/*
+ * The allocation-free formatter of tracef and RETARGET_TRACELIB_PRINTF
+ * (trace_format.c).
+ */
+
+#include <stdarg.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include "host_test.h"
+#include "uart_tracelib.h"
+
+typedef struct {
+    char data[1024];
+    size_t len;
+    uint32_t pieces;
+    size_t longest;
+} sink_t;
+
+static void sink_write(const char *data, size_t len, void *ctx)
+{
+    sink_t *sink = ctx;
+
+    if (sink->len + len < sizeof(sink->data)) {
+        memcpy(sink->data + sink->len, data, len);
+        sink->len += len;
+        sink->data[sink->len] = '\0';
+    }
+    sink->pieces++;
+    if (len > sink->longest) {
+        sink->longest = len;
+    }
+}
+
+static int format(sink_t *sink, char *buf, size_t size, const char *fmt, ...)
+{
+    va_list args;
+
+    memset(sink, 0, sizeof(*sink));
+    va_start(args, fmt);
+    const int len = tracelib_vformat(sink_write, sink, buf, size, fmt, args);
+    va_end(args);
+    return len;
+}
+
+static void test_vformat_pieces(void)
+{
+    static const char long_str[] = "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef";
+    char expected[600];
+    char buf[16];
+    sink_t sink;
+    int n = 0;
+
+    // longer than any buffer of the printf retarget, nothing is cut
+    const int expected_len = snprintf(expected, sizeof(expected), "%s %s %s %s %d%%\n", long_str,
+                                      long_str, long_str, long_str, 42);
+    CHECK_EQ(format(&sink, buf, sizeof(buf), "%s %s %s %s %d%%\n", long_str, long_str, long_str,
+                    long_str, 42), expected_len);
+    CHECK_STR(sink.data, expected);
+    CHECK_EQ(sink.longest, sizeof(buf) - 1);
+    CHECK_EQ(sink.pieces, (expected_len + sizeof(buf) - 2) / (sizeof(buf) - 1));
+
+    // %n counts what was already handed over
+    CHECK_EQ(format(&sink, buf, sizeof(buf), "%s%n.", long_str, &n), sizeof(long_str));
+    CHECK_EQ(n, sizeof(long_str) - 1);
+
+    CHECK_EQ(format(&sink, buf, sizeof(buf), "%s", ""), 0);
+    CHECK_EQ(sink.pieces, 0);
+
+    CHECK_EQ(format(&sink, buf, 2, "%d", 12345), 5);
+    CHECK_STR(sink.data, "12345");
+    CHECK_EQ(sink.pieces, 5);
+}
+
+static double pow10_of(int exp)
+{
+    double value = 1.0;
+    while (exp-- > 0) {
+        value *= 10.0;
+    }
+    return value;
+}
+
+static const char *fmt(const char *format, double value)
+{
+    static char buf[64];
+    tracelib_snprintf(buf, sizeof(buf), format, value);
+    return buf;
+}
+
+static void test_round_half_even(void)
+{
+    // exact halves round to even, like the C library
+    CHECK_STR(fmt("%.1f", 0.25), "0.2");
+    CHECK_STR(fmt("%.1f", 0.75), "0.8");
+    CHECK_STR(fmt("%.2f", 0.125), "0.12");
+    CHECK_STR(fmt("%.2f", 0.375), "0.38");
+    CHECK_STR(fmt("%.0f", 0.5), "0");
+    CHECK_STR(fmt("%.0f", 1.5), "2");
+    CHECK_STR(fmt("%.0f", 2.5), "2");
+    CHECK_STR(fmt("%.0e", 2.5), "2e+00");
+    CHECK_STR(fmt("%.1e", 0.125), "1.2e-01");
+    CHECK_STR(fmt("%.2g", 0.125), "0.12");
+
+    // not halves, the exact binary value decides
+    CHECK_STR(fmt("%.1e", 9.95), "9.9e+00");
+    CHECK_STR(fmt("%.1f", 0.35), "0.3");
+    CHECK_STR(fmt("%.2f", 1.005), "1.00");
+    CHECK_STR(fmt("%.1f", 0.45), "0.5");
+    CHECK_STR(fmt("%.3e", 1.0005), "1.000e+00");
+    CHECK_STR(fmt("%.1e", 9.96), "1.0e+01");
+    CHECK_STR(fmt("%.9f", 0.1), "0.100000000");
+    CHECK_STR(fmt("%.9e", 5e-324), "4.940656458e-324");
+    CHECK_STR(fmt("%e", 1.7976931348623157e308), "1.797693e+308");
+    CHECK_STR(fmt("%.3g", 9.9951), "10");
+}
+
+/* Random finite doubles, all with the same results as glibc */
+static void test_glibc_sweep(void)
+{
+    static const char *const formats[] = {
+        "%.0f", "%.1f", "%.2f", "%.3f", "%.6f", "%.9f", "%#.0f",
+        "%.0e", "%.1e", "%.3e", "%.6e", "%.9e", "%E",
+        "%g", "%.1g", "%.3g", "%.6g", "%#g", "%G",
+    };
+    uint32_t mismatches = 0;
+    char expected[64];
+    char actual[64];
+
+    srand(1);
+    for (uint32_t i = 0; i < 20000; i++) {
+        double value;
+        if (i % 2) {
+            // short decimals, many of them halves and near halves
+            value = (rand() % 100000) / pow10_of(rand() % 6) + (rand() % 2 ? 0.0 : 0.5e-3);
+        } else {
+            uint64_t bits = (uint64_t)rand() << 42 ^ (uint64_t)rand() << 21 ^ (uint64_t)rand();
+            memcpy(&value, &bits, sizeof(value));
+            if (!isfinite(value)) {
+                continue;
+            }
+        }
+        for (uint32_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+            // %f beyond 2^64 is written in %e style on purpose
+            if (formats[f][strlen(formats[f]) - 1] == 'f' && fabs(value) >= 1.8e19) {
+                continue;
+            }
+            snprintf(expected, sizeof(expected), formats[f], value);
+            tracelib_snprintf(actual, sizeof(actual), formats[f], value);
+            if (strcmp(actual, expected) != 0 && mismatches++ < 10) {
+                printf("%s of %a is \"%s\", expected \"%s\"\n", formats[f], value, actual, expected);
+            }
+        }
+    }
+    CHECK_EQ(mismatches, 0);
+}
+
+int main(void)
+{
+    RUN_TEST(test_vformat_pieces);
+    RUN_TEST(test_round_half_even);
+    RUN_TEST(test_glibc_sweep);
+    return host_test_result();
+}
@@ -0,0 +1,219 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+/*
+ * Output ports (trace_port.c) next to the trace UART, both driven by the
+ * transmit engine of trace_tx.c, each with its own driver, ring and prefix.
+ */
+
+#include <pthread.h>
+
+#include "host_test.h"
+#include "host_usart.h"
+#include "trace_port.h"
+#include "uart_tracelib.h"
+
+#define UART 2
+#define PORT_UART 1
+#define PORT_BAUDRATE 921600
+
+static tracelib_port_t port;
+static uint8_t port_buf[1024] __attribute__((aligned(4)));
+static uint32_t port_events;
+static uint32_t released;
+
+static void port_cb(uint32_t event)
+{
+    if (event & ARM_USART_EVENT_SEND_COMPLETE) {
+        port_events++;
+    }
+}
+
+static void release(void *ctx)
+{
+    released += (uint32_t)(uintptr_t)ctx;
+}
+
+static void test_ring_size(void)
+{
+    tracelib_port_t bad;
+    uint8_t buf[96] __attribute__((aligned(4)));
+
+    CHECK_EQ(tracelib_port_init(&bad, &Driver_USART3, buf, sizeof(buf), PORT_BAUDRATE, NULL),
+             ARM_DRIVER_ERROR_PARAMETER);
+    CHECK_EQ(tracelib_port_init(&bad, &Driver_USART3, buf, 0, PORT_BAUDRATE, NULL),
+             ARM_DRIVER_ERROR_PARAMETER);
+}
+
+/* A quarter of a 256 KiB ring no longer fits in the length of a record header */
+static void test_large_ring(void)
+{
+    static uint8_t buf[256 * 1024] __attribute__((aligned(4)));
+    static char data[100000];
+    tracelib_port_t large;
+    uint32_t len;
+
+    for (uint32_t i = 0; i < sizeof(data); i++) {
+        data[i] = (char)('a' + i % 26);
+    }
+    CHECK_EQ(tracelib_port_init(&large, &Driver_USART3, buf, sizeof(buf), PORT_BAUDRATE, NULL), ARM_DRIVER_OK);
+    host_usart_set_speedup(3, 0);
+    host_usart_clear_output(3);
+
+    CHECK_EQ(tracelib_port_send(&large, data, sizeof(data)), ARM_DRIVER_OK);
+    tracelib_port_flush(&large);
+
+    const char *out = host_usart_output(3, &len);
+    CHECK_EQ(len, sizeof(data));
+    CHECK(memcmp(out, data, sizeof(data)) == 0);
+    CHECK_EQ(tracelib_port_uninit(&large), ARM_DRIVER_OK);
+}
+
+static void test_send(void)
+{
+    tracelib_stats_t stats;
+    char data[700];
+    uint32_t len;
+
+    for (uint32_t i = 0; i < sizeof(data); i++) {
+        data[i] = (char)('a' + i % 26);
+    }
+    host_usart_clear_output(PORT_UART);
+    host_usart_clear_output(UART);
+    port_events = 0;
+
+    // goes out in records of a quarter of the ring
+    CHECK_EQ(tracelib_port_send(&port, data, sizeof(data)), ARM_DRIVER_OK);
+    tracelib_port_flush(&port);
+
+    const char *out = host_usart_output(PORT_UART, &len);
+    CHECK_EQ(len, sizeof(data));
+    CHECK(memcmp(out, data, sizeof(data)) == 0);
+    CHECK(port_events >= sizeof(data) / (sizeof(port_buf) / 4));
+    host_usart_output(UART, &len);
+    CHECK_EQ(len, 0);
+
+    tracelib_port_get_stats(&port, &stats);
+    CHECK_EQ(stats.buffer_size, sizeof(port_buf));
+    CHECK_EQ(stats.used, 0);
+    CHECK_EQ(stats.sent_bytes, sizeof(data));
+    CHECK_EQ(stats.dropped_bytes, 0);
+}
+
+static void test_send_ref(void)
+{
+    static const char block[] = "0123456789abcdef";
+    uint32_t len;
+
+    host_usart_clear_output(PORT_UART);
+    released = 0;
+    CHECK_EQ(tracelib_port_send_ref(&port, block, 16, release, (void *)1), ARM_DRIVER_OK);
+    CHECK_EQ(tracelib_port_send(&port, "|", 1), ARM_DRIVER_OK);
+    CHECK_EQ(tracelib_port_send_ref(&port, block, 8, release, (void *)2), ARM_DRIVER_OK);
+    tracelib_port_flush(&port);
+
+    CHECK_STR(host_usart_output(PORT_UART, &len), "0123456789abcdef|01234567");
+    CHECK_EQ(released, 3);
+}
+
+static void test_printf(void)
+{
+    char line[TRACELIB_PORT_LINE_LEN + 16];
+    uint32_t len;
+
+    host_usart_clear_output(PORT_UART);
+    host_usart_clear_output(UART);
+
+    // each instance has its own prefix
+    tracelib_port_set_prefix(&port, "bulk: ");
+    CHECK_EQ(tracelib_port_printf(&port, "%d frames of %s\n", 12, "audio"), ARM_DRIVER_OK);
+    tracef("log line\n");
+    tracelib_port_set_prefix(&port, NULL);
+    CHECK_EQ(tracelib_port_printf(&port, "%04x\n", 0xbeef), ARM_DRIVER_OK);
+    tracelib_port_flush(&port);
+    tracelib_flush();
+
+    CHECK_STR(host_usart_output(PORT_UART, &len), "bulk: 12 frames of audio\nbeef\n");
+    CHECK_STR(host_usart_output(UART, &len), "log: log line\n");
+
+    // long lines are cut like tracef lines
+    memset(line, 'x', sizeof(line) - 1);
+    line[sizeof(line) - 1] = '\0';
+    host_usart_clear_output(PORT_UART);
+    CHECK_EQ(tracelib_port_printf(&port, "%s", line), ARM_DRIVER_OK);
+    tracelib_port_flush(&port);
+    host_usart_output(PORT_UART, &len);
+    CHECK_EQ(len, TRACELIB_PORT_LINE_LEN - 1);
+}
+
+static void *port_writer(void *arg)
+{
+    (void)arg;
+    for (uint32_t i = 0; i < 200; i++) {
+        while (tracelib_port_send(&port, "0123456789\n", 11) != ARM_DRIVER_OK);
+    }
+    return NULL;
+}
+
+/*
+ * The trace UART and the port transmit at the same time, each engine only
+ * sees its own ring and driver.
+ */
+static void test_parallel(void)
+{
+    pthread_t writer;
+    uint32_t len;
+
+    host_usart_set_speedup(PORT_UART, 10);
+    host_usart_set_speedup(UART, 10);
+    host_usart_clear_output(PORT_UART);
+    host_usart_clear_output(UART);
+
+    CHECK_EQ(pthread_create(&writer, NULL, port_writer, NULL), 0);
+    for (uint32_t i = 0; i < 200; i++) {
+        tracef("line %u\n", i);
+    }
+    CHECK_EQ(pthread_join(writer, NULL), 0);
+    tracelib_flush();
+    tracelib_port_flush(&port);
+
+    const char *out = host_usart_output(PORT_UART, &len);
+    CHECK_EQ(len, 200 * 11);
+    for (uint32_t i = 0; i < len; i += 11) {
+        CHECK(memcmp(out + i, "0123456789\n", 11) == 0);
+    }
+    out = host_usart_output(UART, &len);
+    CHECK(strstr(out, "line 0\n") != NULL);
+    CHECK(strstr(out, "line 199\n") != NULL);
+    CHECK(strstr(out, "0123456789") == NULL);
+
+    host_usart_set_speedup(PORT_UART, 0);
+    host_usart_set_speedup(UART, 0);
+}
+
+int main(void)
+{
+    CHECK_EQ(tracelib_init("log: ", NULL), 0);
+    host_usart_set_speedup(UART, 0);
+    CHECK_EQ(tracelib_port_init(&port, &Driver_USART1, port_buf, sizeof(port_buf), PORT_BAUDRATE, port_cb),
+             ARM_DRIVER_OK);
+    host_usart_set_speedup(PORT_UART, 0);
+    CHECK_EQ(host_usart_get_baudrate(PORT_UART), PORT_BAUDRATE);
+
+    RUN_TEST(test_ring_size);
+    RUN_TEST(test_large_ring);
+    RUN_TEST(test_send);
+    RUN_TEST(test_send_ref);
+    RUN_TEST(test_printf);
+    RUN_TEST(test_parallel);
+
+    CHECK_EQ(tracelib_port_uninit(&port), ARM_DRIVER_OK);
+    return host_test_result();
+}
@@ -0,0 +1,133 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+/*
+ * Flight recorder (trace_recorder.c) across simulated resets: writes and
+ * commits interrupted by the reset, and the polled output of the fault path.
+ * The recorder is built into the test with a size, its definitions take the
+ * place of the disabled ones of the library.
+ */
+
+#define TRACELIB_RECORDER_SIZE 1024
+#include "trace_recorder.c"
+
+#include "host_test.h"
+#include "host_usart.h"
+
+#define UART 2
+
+static char recovered[TRACELIB_RECORDER_SIZE + 1];
+
+/* Warm reset: RAM keeps its contents, the recorder starts over */
+static uint32_t reset(void)
+{
+    atomic_store_explicit(&recording, false, memory_order_relaxed);
+    trace_recorder_init();
+
+    const uint32_t len = tracelib_recorder_read(0, recovered, sizeof(recovered) - 1);
+    CHECK_EQ(len, tracelib_recorder_recovered());
+    recovered[len] = '\0';
+    return len;
+}
+
+static bool ends_with(const char *str, const char *suffix)
+{
+    const size_t len = strlen(str);
+    const size_t suffix_len = strlen(suffix);
+    return len >= suffix_len && strcmp(str + len - suffix_len, suffix) == 0;
+}
+
+/* A writer that claimed its bytes and was cut off by the reset */
+static void torn_write(uint32_t len)
+{
+    const uint32_t pos = atomic_fetch_add_explicit(&recorder.reserved, len, memory_order_relaxed);
+    for (uint32_t i = 0; i < len / 2; i++) {
+        recorder.data[(pos + i) & RECORDER_MASK] = '#';
+    }
+}
+
+static void test_commit(void)
+{
+    send_str("before reset\n", 13);
+    tracelib_flush();
+    CHECK(recorder.commit[0].head == recorder.reserved || recorder.commit[1].head == recorder.reserved);
+
+    reset();
+    CHECK(ends_with(recovered, "before reset\n"));
+}
+
+static void test_torn_write(void)
+{
+    trace_recorder_write("complete\n", 9);
+    torn_write(20);
+
+    reset();
+    CHECK(ends_with(recovered, "complete\n"));
+    CHECK(strchr(recovered, '#') == NULL);
+}
+
+static void test_torn_commit(void)
+{
+    trace_recorder_write("one\n", 4);
+    trace_recorder_write("two\n", 4);
+
+    // the reset hit the commit of "two", its slot holds a head without its CRC
+    recorder_commit_t *newest = recorder.commit[0].head == recorder.reserved ? &recorder.commit[0] : &recorder.commit[1];
+    newest->crc ^= 1;
+
+    reset();
+    CHECK(ends_with(recovered, "one\n"));
+}
+
+static void test_overwritten(void)
+{
+    char fill[TRACELIB_RECORDER_SIZE];
+
+    for (uint32_t i = 0; i < sizeof(fill); i++) {
+        fill[i] = (char)('a' + i % 26);
+    }
+    trace_recorder_write(fill, sizeof(fill));
+    // wraps onto the oldest committed bytes
+    torn_write(100);
+
+    CHECK_EQ(reset(), TRACELIB_RECORDER_SIZE - 100);
+    CHECK(memcmp(recovered, fill + 100, TRACELIB_RECORDER_SIZE - 100) == 0);
+}
+
+static void test_bad_header(void)
+{
+    trace_recorder_write("lost\n", 5);
+    recorder.commit[0].crc ^= 1;
+    recorder.commit[1].crc ^= 1;
+
+    CHECK_EQ(reset(), 0);
+}
+
+static void test_polled(void)
+{
+    tracelib_send_polled("fault dump\n", 11);
+
+    reset();
+    CHECK(ends_with(recovered, "fault dump\n"));
+}
+
+int main(void)
+{
+    CHECK_EQ(tracelib_init("", NULL), 0);
+    host_usart_set_speedup(UART, 0);
+
+    RUN_TEST(test_commit);
+    RUN_TEST(test_torn_write);
+    RUN_TEST(test_torn_commit);
+    RUN_TEST(test_overwritten);
+    RUN_TEST(test_bad_header);
+    RUN_TEST(test_polled);
+    return host_test_result();
+}
@@ -0,0 +1,259 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+
+#include "host_test.h"
+#include "trace_ring.h"
+
+#define RING_SIZE 256
+
+static uint8_t ring_buf[RING_SIZE] __attribute__((aligned(4)));
+static trace_ring_t ring;
+
+static void ring_setup(void)
+{
+    memset(ring_buf, 0, sizeof(ring_buf));
+    trace_ring_init(&ring, ring_buf, sizeof(ring_buf));
+}
+
+static uint32_t ring_put(const char *text)
+{
+    uint32_t rec;
+    const uint32_t len = strlen(text);
+    uint8_t *dst = trace_ring_reserve(&ring, len, &rec);
+    if (dst == NULL) {
+        return 0;
+    }
+    memcpy(dst, text, len);
+    trace_ring_commit(&ring, rec, len, len, 0);
+    return len;
+}
+
+/* Consume one record into text, returns its length or -1 if none is ready */
+static int ring_get(char *text)
+{
+    uint32_t hdr;
+    uint8_t *data = trace_ring_peek(&ring, &hdr);
+    if (data == NULL) {
+        return -1;
+    }
+    const uint32_t len = hdr & TRACE_REC_LEN_Msk;
+    memcpy(text, data, len);
+    text[len] = '\0';
+    trace_ring_release(&ring, hdr);
+    return len;
+}
+
+static void test_order(void)
+{
+    char text[RING_SIZE];
+
+    ring_setup();
+    CHECK(trace_ring_empty(&ring));
+    CHECK_EQ(ring_put("first"), 5);
+    CHECK_EQ(ring_put("second"), 6);
+    CHECK(trace_ring_ready(&ring));
+    CHECK_EQ(ring_get(text), 5);
+    CHECK_STR(text, "first");
+    CHECK_EQ(ring_get(text), 6);
+    CHECK_STR(text, "second");
+    CHECK_EQ(ring_get(text), -1);
+    CHECK(trace_ring_empty(&ring));
+}
+
+static void test_wrap(void)
+{
+    char text[RING_SIZE];
+    char line[64];
+
+    ring_setup();
+    // records never wrap, the end of the buffer is skipped
+    for (int i = 0; i < 100; i++) {
+        snprintf(line, sizeof(line), "record %d with some padding", i);
+        CHECK_EQ(ring_put(line), strlen(line));
+        CHECK_EQ(ring_get(text), strlen(line));
+        CHECK_STR(text, line);
+    }
+    CHECK_EQ(atomic_load(&ring.dropped), 0);
+}
+
+static void test_full(void)
+{
+    char text[RING_SIZE];
+    uint32_t queued = 0;
+
+    ring_setup();
+    while (ring_put("0123456789abcdef") != 0) {
+        queued++;
+    }
+    // 16 byte payload + 4 byte header
+    CHECK_EQ(queued, RING_SIZE / 20);
+    CHECK_EQ(atomic_load(&ring.dropped), 16);
+    CHECK_EQ(ring_get(text), 16);
+    CHECK_EQ(ring_put("0123456789abcdef"), 16);
+}
+
+static void test_oversized(void)
+{
+    uint32_t rec;
+
+    ring_setup();
+    CHECK(trace_ring_reserve(&ring, RING_SIZE, &rec) == NULL);
+    // larger than the header length field, must not wrap into the flags
+    CHECK(trace_ring_reserve(&ring, TRACE_REC_LEN_Msk + 1, &rec) == NULL);
+    CHECK(trace_ring_reserve(&ring, UINT32_MAX - 2, &rec) == NULL);
+    CHECK(trace_ring_empty(&ring));
+    CHECK(trace_ring_fits(&ring, RING_SIZE / 2));
+    CHECK(!trace_ring_fits(&ring, RING_SIZE));
+}
+
+/* The header, padding and abandon records of a ring above 64 KiB */
+static void test_max_len(void)
+{
+    static uint8_t large_buf[256 * 1024] __attribute__((aligned(4)));
+    trace_ring_t large;
+    uint32_t rec;
+    uint32_t hdr;
+
+    trace_ring_init(&large, large_buf, sizeof(large_buf));
+    CHECK(trace_ring_reserve(&large, TRACE_REC_MAX_LEN + 1, &rec) == NULL);
+    CHECK(!trace_ring_fits(&large, TRACE_REC_MAX_LEN + 1));
+
+    // abandoned in full, the skip record must not spill into the flags
+    CHECK(trace_ring_reserve(&large, TRACE_REC_MAX_LEN, &rec) != NULL);
+    trace_ring_commit(&large, rec, TRACE_REC_MAX_LEN, 0, 0);
+    CHECK(trace_ring_peek(&large, &hdr) == NULL);
+    CHECK(trace_ring_empty(&large));
+
+    uint8_t *dst = trace_ring_reserve(&large, TRACE_REC_MAX_LEN, &rec);
+    CHECK(dst != NULL);
+    memset(dst, 'x', TRACE_REC_MAX_LEN);
+    trace_ring_commit(&large, rec, TRACE_REC_MAX_LEN, TRACE_REC_MAX_LEN, 0);
+    CHECK(trace_ring_peek(&large, &hdr) != NULL);
+    CHECK_EQ(hdr & TRACE_REC_LEN_Msk, TRACE_REC_MAX_LEN);
+    CHECK(!(hdr & TRACE_REC_SKIP));
+    trace_ring_release(&large, hdr);
+    CHECK(trace_ring_empty(&large));
+}
+
+static void test_partial_commit(void)
+{
+    char text[RING_SIZE];
+    uint32_t rec;
+
+    ring_setup();
+    uint8_t *dst = trace_ring_reserve(&ring, 64, &rec);
+    CHECK(dst != NULL);
+    memcpy(dst, "short", 5);
+    trace_ring_commit(&ring, rec, 64, 5, 0);
+    CHECK_EQ(ring_put("next"), 4);
+    CHECK_EQ(ring_get(text), 5);
+    CHECK_STR(text, "short");
+    CHECK_EQ(ring_get(text), 4);
+    CHECK_STR(text, "next");
+}
+
+static void test_abandon(void)
+{
+    char text[RING_SIZE];
+    uint32_t rec;
+
+    ring_setup();
+    CHECK(trace_ring_reserve(&ring, 32, &rec) != NULL);
+    CHECK_EQ(ring_put("after"), 5);
+    // the open reservation blocks the consumer until it is committed
+    CHECK_EQ(ring_get(text), -1);
+    trace_ring_commit(&ring, rec, 32, 0, 0);
+    CHECK_EQ(ring_get(text), 5);
+    CHECK_STR(text, "after");
+}
+
+#define PRODUCERS 4
+#define PER_PRODUCER 20000
+
+static void *producer(void *arg)
+{
+    const uint32_t id = (uint32_t)(uintptr_t)arg;
+
+    for (uint32_t seq = 0; seq < PER_PRODUCER; seq++) {
+        uint32_t rec;
+        uint32_t *dst;
+        // variable length records, the payload repeats the sequence number
+        const uint32_t words = 1 + seq % 7;
+        while ((dst = (uint32_t *)trace_ring_reserve(&ring, words * 8, &rec)) == NULL) {
+            sched_yield();
+        }
+        for (uint32_t i = 0; i < words; i++) {
+            dst[2 * i] = id;
+            dst[2 * i + 1] = seq;
+        }
+        trace_ring_commit(&ring, rec, words * 8, words * 8, 0);
+    }
+    return NULL;
+}
+
+static void test_producers(void)
+{
+    pthread_t threads[PRODUCERS];
+    uint32_t next[PRODUCERS] = { 0 };
+    uint32_t records = 0;
+    bool intact = true;
+
+    ring_setup();
+    for (uintptr_t i = 0; i < PRODUCERS; i++) {
+        pthread_create(&threads[i], NULL, producer, (void *)i);
+    }
+
+    while (records < PRODUCERS * PER_PRODUCER) {
+        uint32_t hdr;
+        const uint32_t *data = (const uint32_t *)trace_ring_peek(&ring, &hdr);
+        if (data == NULL) {
+            sched_yield();
+            continue;
+        }
+        const uint32_t len = hdr & TRACE_REC_LEN_Msk;
+        const uint32_t id = data[0];
+        const uint32_t seq = data[1];
+        // every producer's records arrive in order and unmixed
+        if (id < PRODUCERS && seq == next[id] && len == (1 + seq % 7) * 8) {
+            for (uint32_t i = 0; i < len / 4; i += 2) {
+                intact &= data[i] == id && data[i + 1] == seq;
+            }
+            next[id]++;
+        } else {
+            intact = false;
+        }
+        records++;
+        trace_ring_release(&ring, hdr);
+    }
+
+    for (int i = 0; i < PRODUCERS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    CHECK(intact);
+    CHECK_EQ(records, PRODUCERS * PER_PRODUCER);
+    CHECK(trace_ring_empty(&ring));
+}
+
+int main(void)
+{
+    RUN_TEST(test_order);
+    RUN_TEST(test_wrap);
+    RUN_TEST(test_full);
+    RUN_TEST(test_oversized);
+    RUN_TEST(test_max_len);
+    RUN_TEST(test_partial_commit);
+    RUN_TEST(test_abandon);
+    RUN_TEST(test_producers);
+    return host_test_result();
+}
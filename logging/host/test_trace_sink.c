@@ -0,0 +1,171 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+/*
+ * Output sinks: the ITM on the register stand-in, the RAM buffer, the user
+ * callback, the null sink and combinations with the UART.
+ */
+
+#include <RTE_Components.h>
+#include CMSIS_device_header
+
+#include "host_itm.h"
+#include "host_test.h"
+#include "host_usart.h"
+#include "trace_sink.h"
+#include "uart_tracelib.h"
+
+#define UART 2
+#define ITM_PORT 0
+
+static char user_out[1024];
+static uint32_t user_len;
+
+static void user_write(const void *data, uint32_t len)
+{
+    if (user_len + len < sizeof(user_out)) {
+        memcpy(user_out + user_len, data, len);
+        user_len += len;
+        user_out[user_len] = '\0';
+    }
+}
+
+static void sinks_reset(uint32_t sinks)
+{
+    tracelib_flush();
+    tracelib_set_sinks(sinks);
+    host_usart_clear_output(UART);
+    host_itm_clear();
+    user_len = 0;
+    user_out[0] = '\0';
+    tracelib_reset_stats();
+}
+
+static void itm_enable(bool enable)
+{
+    ITM->TER = enable ? 1UL << ITM_PORT : 0;
+    ITM->TCR = enable ? ITM_TCR_ITMENA_Msk : 0;
+}
+
+static void test_itm(void)
+{
+    host_itm_stats_t stats;
+    uint32_t len;
+
+    sinks_reset(TRACELIB_SINK_ITM);
+    itm_enable(true);
+    tracef("itm %d\n", 1);
+    send_str("odd length\n", 11);
+    tracelib_flush();
+    CHECK_STR(host_itm_output(ITM_PORT, &len), "[T] itm 1\nodd length\n");
+    // whole words first, the tail byte by byte
+    host_itm_get_stats(&stats);
+    CHECK_EQ(stats.writes, 10 / 4 + 10 % 4 + 11 / 4 + 11 % 4);
+    CHECK_EQ(stats.violations, 0);
+    CHECK_STR(host_usart_output(UART, NULL), "");
+}
+
+static void test_itm_stall(void)
+{
+    host_itm_stats_t stats;
+
+    sinks_reset(TRACELIB_SINK_ITM);
+    itm_enable(true);
+    host_itm_stall(100);
+    tracef("slow debugger\n");
+    tracelib_flush();
+    CHECK_STR(host_itm_output(ITM_PORT, NULL), "[T] slow debugger\n");
+    host_itm_get_stats(&stats);
+    CHECK_EQ(stats.stalled, 100);
+    CHECK_EQ(stats.violations, 0);
+}
+
+static void test_itm_disabled(void)
+{
+    sinks_reset(TRACELIB_SINK_ITM);
+    itm_enable(false);
+    tracef("no debugger\n");
+    tracelib_flush();
+    CHECK_STR(host_itm_output(ITM_PORT, NULL), "");
+
+    // the port must be enabled as well
+    ITM->TCR = ITM_TCR_ITMENA_Msk;
+    tracef("no port\n");
+    tracelib_flush();
+    CHECK_STR(host_itm_output(ITM_PORT, NULL), "");
+}
+
+static void test_ram(void)
+{
+    char line[64];
+
+    sinks_reset(TRACELIB_SINK_RAM);
+    const uint32_t head = tracelib_ram_sink.head;
+    tracef("ram\n");
+    tracelib_flush();
+    CHECK_EQ(tracelib_ram_sink.head - head, 8);
+    CHECK(memcmp(&tracelib_ram_sink.data[head % TRACELIB_RAM_SINK_SIZE], "[T] ram\n", 8) == 0);
+
+    // the oldest output is overwritten, the newest line is intact at the head
+    for (int i = 0; i < 200; i++) {
+        tracef("line %03d of the ram sink wrap test\n", i);
+        if (i % 16 == 15) {
+            tracelib_flush();
+        }
+    }
+    tracelib_flush();
+    const int len = snprintf(line, sizeof(line), "[T] line %03d of the ram sink wrap test\n", 199);
+    char last[64];
+    for (int i = 0; i < len; i++) {
+        last[i] = tracelib_ram_sink.data[(tracelib_ram_sink.head - len + i) % TRACELIB_RAM_SINK_SIZE];
+    }
+    CHECK(memcmp(last, line, len) == 0);
+    CHECK_EQ(tracelib_ram_sink.head - head, 8 + 200 * len);
+}
+
+static void test_user_and_uart(void)
+{
+    sinks_reset(TRACELIB_SINK_UART | TRACELIB_SINK_USER);
+    tracelib_set_user_sink(user_write);
+    tracef("both %s\n", "ways");
+    tracelib_flush();
+    CHECK_STR(user_out, "[T] both ways\n");
+    CHECK_STR(host_usart_output(UART, NULL), "[T] both ways\n");
+    tracelib_set_user_sink(NULL);
+}
+
+static void test_null(void)
+{
+    tracelib_stats_t stats;
+
+    sinks_reset(TRACELIB_SINK_NULL);
+    itm_enable(true);
+    tracef("nowhere\n");
+    tracelib_flush();
+    tracelib_get_stats(&stats);
+    CHECK_EQ(stats.sent_bytes, 12);
+    CHECK_EQ(stats.dropped_bytes, 0);
+    CHECK_STR(host_usart_output(UART, NULL), "");
+    CHECK_STR(host_itm_output(ITM_PORT, NULL), "");
+}
+
+int main(void)
+{
+    CHECK_EQ(tracelib_init("[T] ", NULL), 0);
+    host_usart_set_speedup(UART, 0);
+
+    RUN_TEST(test_itm);
+    RUN_TEST(test_itm_stall);
+    RUN_TEST(test_itm_disabled);
+    RUN_TEST(test_ram);
+    RUN_TEST(test_user_and_uart);
+    RUN_TEST(test_null);
+    return host_test_result();
+}
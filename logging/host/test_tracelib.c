@@ -0,0 +1,271 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+/*
+ * tracef, send_str and the _write retarget path on the stand-in UART of the
+ * HP core (Driver_USART2).
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <RTE_Components.h>
+#include CMSIS_device_header
+
+#include "host_fault.h"
+#include "host_retarget.h"
+#include "host_test.h"
+#include "host_usart.h"
+#include "uart_tracelib.h"
+
+#define UART 2
+#define STDOUT 1
+
+static void output_reset(uint32_t speedup)
+{
+    tracelib_flush();
+    host_usart_set_speedup(UART, speedup);
+    host_usart_clear_output(UART);
+    tracelib_reset_stats();
+}
+
+static void test_tracef(void)
+{
+    output_reset(0);
+    tracef("hello %d\n", 42);
+    tracef("%s|%5.2f|%x\n", "str", 3.14159, 0xbeefU);
+    tracelib_flush();
+    CHECK_STR(host_usart_output(UART, NULL), "[T] hello 42\n[T] str| 3.14|beef\n");
+}
+
+static void test_send_str(void)
+{
+    output_reset(0);
+    CHECK_EQ(send_str("raw\n", 4), ARM_DRIVER_OK);
+    CHECK_EQ(host_write(STDOUT, (const unsigned char *)"write\n", 6, 0), 6);
+    tracelib_flush();
+    CHECK_STR(host_usart_output(UART, NULL), "raw\nwrite\n");
+
+    tracelib_stats_t stats;
+    tracelib_get_stats(&stats);
+    CHECK_EQ(stats.sent_bytes, 10);
+    CHECK_EQ(stats.dropped_bytes, 0);
+}
+
+static void test_drop_accounting(void)
+{
+    char line[101];
+    tracelib_stats_t stats;
+    uint32_t output_len;
+
+    // 115200 baud: the ring fills long before the lines are sent
+    output_reset(1);
+    memset(line, 'x', sizeof(line) - 2);
+    line[sizeof(line) - 2] = '\n';
+    line[sizeof(line) - 1] = '\0';
+    for (int i = 0; i < 100; i++) {
+        tracef("%s", line);
+    }
+    host_usart_set_speedup(UART, 0);
+    tracelib_flush();
+    tracelib_get_stats(&stats);
+    host_usart_output(UART, &output_len);
+
+    // dropped lines count with their length, not the reservation size
+    CHECK(stats.dropped_bytes > 0);
+    CHECK_EQ(stats.dropped_bytes % 104, 0);
+    CHECK_EQ(stats.dropped_bytes + output_len, 100 * 104);
+}
+
+static void test_write_waits(void)
+{
+    char line[100];
+    char block[8000];
+    tracelib_stats_t stats;
+    uint32_t output_len;
+
+    // printf from a thread waits for room instead of dropping
+    output_reset(10);
+    memset(line, 'y', sizeof(line) - 1);
+    line[sizeof(line) - 1] = '\n';
+    for (int i = 0; i < 100; i++) {
+        CHECK_EQ(host_write(STDOUT, (const unsigned char *)line, sizeof(line), 0), sizeof(line));
+    }
+    tracelib_flush();
+    tracelib_get_stats(&stats);
+    host_usart_output(UART, &output_len);
+    CHECK_EQ(output_len, 100 * sizeof(line));
+    CHECK_EQ(stats.dropped_bytes, 0);
+
+    // with interrupts disabled it can not wait, the short count shows the loss
+    output_reset(10);
+    memset(block, 'z', sizeof(block));
+    __disable_irq();
+    const int written = host_write(STDOUT, (const unsigned char *)block, sizeof(block), 0);
+    __enable_irq();
+    tracelib_flush();
+    tracelib_get_stats(&stats);
+    host_usart_output(UART, &output_len);
+    CHECK(written > 0 && written < (int)sizeof(block));
+    CHECK_EQ(output_len, written);
+    CHECK_EQ(stats.dropped_bytes, sizeof(block) - written);
+    host_usart_set_speedup(UART, 0);
+}
+
+#define THREADS 4
+#define LINES 500
+
+static void *trace_thread(void *arg)
+{
+    const int id = (int)(intptr_t)arg;
+
+    for (int i = 0; i < LINES; i++) {
+        tracef("thread %d line %d\n", id, i);
+    }
+    return NULL;
+}
+
+static void test_threads(void)
+{
+    pthread_t threads[THREADS];
+    int next[THREADS] = { 0 };
+    uint32_t expected_len = 0;
+    uint32_t output_len;
+    tracelib_stats_t stats;
+    bool intact = true;
+
+    output_reset(0);
+    for (intptr_t i = 0; i < THREADS; i++) {
+        pthread_create(&threads[i], NULL, trace_thread, (void *)i);
+    }
+    for (int i = 0; i < THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    tracelib_flush();
+    tracelib_get_stats(&stats);
+
+    // whole lines in per thread order, dropped lines are left out as a whole
+    const char *out = host_usart_output(UART, &output_len);
+    while (*out) {
+        int id;
+        int line;
+        int len;
+        if (sscanf(out, "[T] thread %d line %d\n%n", &id, &line, &len) != 2 ||
+            id < 0 || id >= THREADS || line < next[id]) {
+            intact = false;
+            break;
+        }
+        next[id] = line + 1;
+        out += len;
+    }
+    for (int id = 0; id < THREADS; id++) {
+        for (int line = 0; line < LINES; line++) {
+            expected_len += snprintf(NULL, 0, "[T] thread %d line %d\n", id, line);
+        }
+    }
+    CHECK(intact);
+    CHECK_EQ(stats.dropped_bytes + output_len, expected_len);
+    // the threads run at the same time, not preempting each other like on the target
+    CHECK_EQ(stats.context_calls[TRACELIB_CONTEXT_THREAD] + stats.context_calls[TRACELIB_CONTEXT_NESTED],
+             THREADS * LINES);
+}
+
+/* A line longer than the receive ring comes back truncated to the ring */
+static void test_read_long_line(void)
+{
+    char line[TRACELIB_RX_BUFFER_SIZE + 44];
+    char buf[2 * TRACELIB_RX_BUFFER_SIZE];
+    uint32_t available;
+    uint32_t overflow;
+
+    for (uint32_t i = 0; i < sizeof(line) - 1; i++) {
+        line[i] = (char)('a' + i % 26);
+    }
+    line[sizeof(line) - 1] = '\n';
+    host_usart_inject(UART, line, sizeof(line), 0);
+
+    CHECK_EQ(tracelib_read_line(buf, sizeof(buf), 1000), TRACELIB_RX_BUFFER_SIZE);
+    CHECK(memcmp(buf, line, TRACELIB_RX_BUFFER_SIZE) == 0);
+
+    // the rest of the line either follows or was dropped while the ring was full
+    while (tracelib_read(buf, sizeof(buf), 100) > 0) {
+    }
+    tracelib_get_rx_stats(&available, &overflow);
+    CHECK_EQ(available, 0);
+}
+
+/* Shell replies are not rate limited, words may be separated by any blanks */
+static void test_shell(void)
+{
+    char help[] = "help";
+    char level[] = " \tlevel  3\t 2 ";
+
+    output_reset(0);
+    tracelib_set_rate_limit(1, 60000);
+    tracelib_shell_execute(help);
+    tracelib_shell_execute(level);
+    tracelib_set_rate_limit(0, 1000);
+    tracelib_flush();
+
+    const char *out = host_usart_output(UART, NULL);
+    CHECK(strstr(out, "[T] help list commands\n[T] level ") != NULL);
+    CHECK(strstr(out, "[T] dump send the output") != NULL);
+    CHECK(strstr(out, "[T] module 3 level 2\n") != NULL);
+    CHECK_EQ(tracelib_get_level(3), 2);
+
+    tracelib_stats_t stats;
+    tracelib_get_stats(&stats);
+    CHECK_EQ(stats.suppressed, 0);
+}
+
+/* Last test, the process cannot leave the fault */
+static void test_fault_output(void)
+{
+    tracelib_reservation_t res;
+    char line[80];
+
+    output_reset(1);
+    tracef("before\n");
+    memset(line, '-', sizeof(line) - 1);
+    line[sizeof(line) - 1] = '\n';
+    send_str(line, sizeof(line));
+    // a thread interrupted between reserve and commit
+    CHECK(tracelib_reserve(16, &res) != NULL);
+    tracef("lost\n");
+
+    host_fault_enter();
+    const char dump[] = "HardFault\n";
+    CHECK_EQ(host_write(STDOUT, (const unsigned char *)dump, sizeof(dump) - 1, 0), sizeof(dump) - 1);
+
+    // the interrupted transmission is sent again from the start, then the
+    // records up to the open reservation and the dump, with polling only
+    char expected[sizeof(line) + sizeof(dump)];
+    memcpy(expected, line, sizeof(line));
+    memcpy(expected + sizeof(line), dump, sizeof(dump));
+    const char *out = host_usart_output(UART, NULL);
+    const size_t out_len = strlen(out);
+    CHECK(strstr(out, "[T] before\n") != NULL);
+    CHECK(strstr(out, "lost") == NULL);
+    CHECK(out_len >= strlen(expected) && strcmp(out + out_len - strlen(expected), expected) == 0);
+}
+
+int main(void)
+{
+    CHECK_EQ(tracelib_init("[T] ", NULL), 0);
+
+    RUN_TEST(test_tracef);
+    RUN_TEST(test_send_str);
+    RUN_TEST(test_drop_accounting);
+    RUN_TEST(test_write_waits);
+    RUN_TEST(test_threads);
+    RUN_TEST(test_read_long_line);
+    RUN_TEST(test_shell);
+    RUN_TEST(test_fault_output);
+    return host_test_result();
+}
@@ -0,0 +1,395 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+/*
+ * Benchmarks of tracelib on the stand-in UART of the host build:
+ *
+ *   latency     nanoseconds per call of the producer API, the UART completes
+ *               every Send at once so the ring never fills
+ *   throughput  bytes per second a single producer gets through at several
+ *               baud rates, the stand-in runs at the real wire speed
+ *   drop rate   lines lost at 115200 baud when the offered load is paced to
+ *               a fraction of the wire capacity
+ *   contention  1 to 8 threads writing at the same time, reservation retries
+ *               and lines lost
+ *   printf      a printf of one line through the retarget _write as the
+ *               toolchains do it: unbuffered (picolibc stderr and _IONBF),
+ *               line and fully buffered (RETARGET_STDOUT_BUFFER_SIZE) after
+ *               C library formatting, and RETARGET_TRACELIB_PRINTF
+ *   encoding    the hex, decimal and ASCII kernels of hex and fault dumps
+ *               against snprintf, portable path as there is no Helium here
+ *
+ *   tracelib_bench [--quick]
+ *
+ * --quick shortens every run, for CI where only the trend matters.
+ */
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "host_bench.h"
+#include "host_retarget.h"
+#include "host_usart.h"
+#include "trace_encode.h"
+#include "uart_tracelib.h"
+
+#define UART 2
+#define STDOUT 1
+#define LINE_LEN 64
+#define LATENCY_BATCH 32
+
+static bool quick;
+
+static void output_reset(uint32_t speedup)
+{
+    tracelib_flush();
+    host_usart_set_speedup(UART, speedup);
+    host_usart_clear_output(UART);
+    host_usart_reset_stats(UART);
+    tracelib_reset_stats();
+}
+
+/* LINE_LEN bytes including the "[B] " prefix and the newline */
+static const char line[] = "0123456789abcdef0123456789abcdef0123456789abcdef0123456789a\n";
+_Static_assert(sizeof(line) - 1 + 4 == LINE_LEN, "line length");
+
+typedef enum {
+    CALL_CLOCK,
+    CALL_TRACEF_STR,
+    CALL_TRACEF_INT,
+    CALL_TRACEF_FLOAT,
+    CALL_SEND_STR,
+    CALL_WRITE,
+    CALL_SNPRINTF,
+    CALL_LIBC_SNPRINTF,
+    CALL_SNPRINTF_FLOAT,
+    CALL_LIBC_SNPRINTF_FLOAT,
+    CALL_PRINTF_UNBUFFERED,
+    CALL_PRINTF_LINE,
+    CALL_PRINTF_FULL,
+    CALL_PRINTF_TRACELIB,
+    CALL_ENCODE_HEX8,
+    CALL_LIBC_HEX8,
+    CALL_ENCODE_HEX32,
+    CALL_LIBC_HEX32,
+    CALL_ENCODE_DEC32,
+    CALL_LIBC_DEC32,
+    CALL_ENCODE_ASCII,
+} call_t;
+
+/* The stdout buffer of the picolibc retarget, fully buffered */
+static char stdout_buf[128];
+static unsigned int stdout_len;
+
+static void printf_write(const char *data, size_t len, void *ctx)
+{
+    (void)ctx;
+    host_write(STDOUT, (const unsigned char *)data, len, 0);
+}
+
+static void bench_printf(call_t which, const char *format, ...)
+{
+    char buf[LINE_LEN];
+    va_list args;
+
+    va_start(args, format);
+    if (which == CALL_PRINTF_TRACELIB) {
+        tracelib_vformat(printf_write, NULL, buf, sizeof(buf), format, args);
+        va_end(args);
+        return;
+    }
+    const int len = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+
+    for (int i = 0; i < len && which == CALL_PRINTF_UNBUFFERED; i++) {
+        printf_write(&buf[i], 1, NULL);
+    }
+    if (which == CALL_PRINTF_LINE) {
+        printf_write(buf, len, NULL);
+    }
+    for (int i = 0; i < len && which == CALL_PRINTF_FULL; i++) {
+        stdout_buf[stdout_len++] = buf[i];
+        if (stdout_len == sizeof(stdout_buf)) {
+            printf_write(stdout_buf, stdout_len, NULL);
+            stdout_len = 0;
+        }
+    }
+}
+
+static void call(call_t which, uint32_t i)
+{
+    static const uint32_t words[4] = { 0x20001F40, 0xDEADBEEF, 0x00000010, 0x8000A5C3 };
+    char buf[LINE_LEN];
+    char dump[40];
+
+    switch (which) {
+    case CALL_CLOCK:
+        break;
+    case CALL_TRACEF_STR:
+        tracef("%s", line);
+        break;
+    case CALL_TRACEF_INT:
+        tracef("value %d of %u at %x\n", -(int)i, i, i * 0x9e3779b9U);
+        break;
+    case CALL_TRACEF_FLOAT:
+        tracef("value %.3f\n", i * 0.001);
+        break;
+    case CALL_SEND_STR:
+        send_str(line, sizeof(line) - 1);
+        break;
+    case CALL_WRITE:
+        host_write(STDOUT, (const unsigned char *)line, sizeof(line) - 1, 0);
+        break;
+    case CALL_SNPRINTF:
+        tracelib_snprintf(buf, sizeof(buf), "value %d of %u at %x\n", -(int)i, i, i * 0x9e3779b9U);
+        break;
+    case CALL_LIBC_SNPRINTF:
+        snprintf(buf, sizeof(buf), "value %d of %u at %x\n", -(int)i, i, i * 0x9e3779b9U);
+        break;
+    case CALL_SNPRINTF_FLOAT:
+        tracelib_snprintf(buf, sizeof(buf), "%.3f %.6e %g\n", i * 0.001, i * 1.1e-7, i * 25.5);
+        break;
+    case CALL_LIBC_SNPRINTF_FLOAT:
+        snprintf(buf, sizeof(buf), "%.3f %.6e %g\n", i * 0.001, i * 1.1e-7, i * 25.5);
+        break;
+    case CALL_PRINTF_UNBUFFERED:
+    case CALL_PRINTF_LINE:
+    case CALL_PRINTF_FULL:
+    case CALL_PRINTF_TRACELIB:
+        bench_printf(which, "value %d of %u at %x\n", -(int)i, i, i * 0x9e3779b9U);
+        break;
+    case CALL_ENCODE_HEX8:
+        trace_encode_hex8(dump, line, 16);
+        break;
+    case CALL_LIBC_HEX8:
+        for (uint32_t b = 0; b < 16; b++) {
+            snprintf(&dump[b * 2], 3, "%02X", (uint8_t)line[b]);
+        }
+        break;
+    case CALL_ENCODE_HEX32:
+        trace_encode_hex32(dump, words, 4);
+        break;
+    case CALL_LIBC_HEX32:
+        snprintf(dump, sizeof(dump), "%08X%08X%08X%08X", words[0], words[1], words[2], words[3]);
+        break;
+    case CALL_ENCODE_DEC32:
+        trace_encode_dec32(dump, i * 0x9e3779b9U);
+        break;
+    case CALL_LIBC_DEC32:
+        snprintf(dump, sizeof(dump), "%u", i * 0x9e3779b9U);
+        break;
+    case CALL_ENCODE_ASCII:
+        trace_encode_ascii(dump, line, 16);
+        break;
+    }
+    // keep the compiler from dropping the encoding
+    __asm__ volatile("" : : "r"(dump) : "memory");
+}
+
+static void bench_call(const char *name, call_t which)
+{
+    const uint32_t calls = quick ? 2000 : 50000;
+    bench_latency_t lat;
+
+    bench_latency_init(&lat, calls);
+    output_reset(0);
+    for (uint32_t i = 0; i < calls; i++) {
+        const uint64_t start = bench_now_ns();
+        call(which, i);
+        bench_latency_add(&lat, bench_now_ns() - start);
+        if (i % LATENCY_BATCH == LATENCY_BATCH - 1) {
+            tracelib_flush();
+        }
+    }
+    tracelib_flush();
+    bench_latency_report(name, &lat);
+}
+
+static void bench_latency(void)
+{
+    bench_latency_header("Latency");
+    bench_call("clock_gettime (timer overhead)", CALL_CLOCK);
+    bench_call("tracef 64 byte string", CALL_TRACEF_STR);
+    bench_call("tracef 3 integers", CALL_TRACEF_INT);
+    bench_call("tracef %.3f", CALL_TRACEF_FLOAT);
+    bench_call("send_str 60 bytes", CALL_SEND_STR);
+    bench_call("_write 60 bytes (printf retarget)", CALL_WRITE);
+    bench_call("tracelib_snprintf 3 integers", CALL_SNPRINTF);
+    bench_call("libc snprintf 3 integers", CALL_LIBC_SNPRINTF);
+    bench_call("tracelib_snprintf %f %e %g", CALL_SNPRINTF_FLOAT);
+    bench_call("libc snprintf %f %e %g", CALL_LIBC_SNPRINTF_FLOAT);
+}
+
+static void bench_encode(void)
+{
+    bench_latency_header("Encoding kernels, 16 bytes, portable path");
+    bench_call("trace_encode_hex8", CALL_ENCODE_HEX8);
+    bench_call("snprintf %02X per byte", CALL_LIBC_HEX8);
+    bench_call("trace_encode_hex32 4 words", CALL_ENCODE_HEX32);
+    bench_call("snprintf %08X 4 words", CALL_LIBC_HEX32);
+    bench_call("trace_encode_dec32", CALL_ENCODE_DEC32);
+    bench_call("snprintf %u", CALL_LIBC_DEC32);
+    bench_call("trace_encode_ascii", CALL_ENCODE_ASCII);
+}
+
+static void bench_printf_modes(void)
+{
+    bench_latency_header("printf of 3 integers per stdout mode");
+    bench_call("unbuffered, _write per char", CALL_PRINTF_UNBUFFERED);
+    bench_call("line buffered, _write per line", CALL_PRINTF_LINE);
+    bench_call("fully buffered, 128 byte _write", CALL_PRINTF_FULL);
+    bench_call("RETARGET_TRACELIB_PRINTF", CALL_PRINTF_TRACELIB);
+}
+
+/*
+ * Offer LINE_LEN byte lines for duration_ms at load percent of the wire
+ * capacity, 0 writes as fast as possible. Prints one table row.
+ */
+static void run_load(uint32_t speedup, uint32_t load, uint32_t duration_ms)
+{
+    const uint32_t baudrate = host_usart_get_baudrate(UART) * speedup;
+    const uint64_t line_ns = (uint64_t)LINE_LEN * 10 * 1000000000U / baudrate;
+    const uint64_t interval_ns = load ? line_ns * 100 / load : 0;
+    tracelib_stats_t stats;
+    host_usart_stats_t uart;
+    uint32_t lines = 0;
+
+    output_reset(speedup);
+    const uint64_t start = bench_now_ns();
+    const uint64_t end = start + (uint64_t)duration_ms * 1000000U;
+    uint64_t next = start;
+    while (bench_now_ns() < end) {
+        if (interval_ns) {
+            while (bench_now_ns() < next);
+            next += interval_ns;
+        }
+        tracef("%s", line);
+        lines++;
+    }
+    host_usart_get_stats(UART, &uart);
+    tracelib_get_stats(&stats);
+    const double elapsed_s = (bench_now_ns() - start) / 1e9;
+
+    // whatever was still queued is not part of the measurement
+    host_usart_set_speedup(UART, 0);
+    tracelib_flush();
+
+    const uint64_t offered = (uint64_t)lines * LINE_LEN;
+    char load_text[8];
+    snprintf(load_text, sizeof(load_text), load ? "%u%%" : "max", load);
+    printf("  %8u %6s %10.0f %10.0f %7.1f%% %7.1f%% %9u\n", baudrate, load_text,
+           offered / elapsed_s, uart.tx_bytes / elapsed_s,
+           100.0 * uart.busy_ns / 1e9 / elapsed_s, 100.0 * stats.dropped_bytes / offered,
+           stats.high_water);
+}
+
+static void load_header(const char *title)
+{
+    printf("\n%s\n  %8s %6s %10s %10s %8s %8s %9s\n", title, "baud", "load", "offered/s",
+           "sent/s", "wire", "dropped", "highwater");
+}
+
+static void bench_throughput(void)
+{
+    // the stand-in runs at 115200 baud times the speedup
+    static const uint32_t speedups[] = { 1, 8, 26 };
+
+    load_header("Throughput, one producer as fast as possible");
+    for (uint32_t i = 0; i < sizeof(speedups) / sizeof(speedups[0]); i++) {
+        run_load(speedups[i], 0, quick ? 50 : 500);
+    }
+}
+
+static void bench_drop_rate(void)
+{
+    static const uint32_t loads[] = { 50, 90, 100, 110, 200 };
+
+    load_header("Drop rate, one producer paced to a share of the wire");
+    for (uint32_t i = 0; i < sizeof(loads) / sizeof(loads[0]); i++) {
+        run_load(1, loads[i], quick ? 100 : 1000);
+    }
+}
+
+typedef struct {
+    pthread_t thread;
+    uint32_t id;
+    uint32_t lines;
+    uint64_t ns;
+} producer_t;
+
+static volatile bool producers_go;
+
+static void *producer(void *arg)
+{
+    producer_t *p = arg;
+
+    while (!producers_go);
+    const uint64_t start = bench_now_ns();
+    for (uint32_t i = 0; i < p->lines; i++) {
+        tracef("thread %u line %u\n", p->id, i);
+    }
+    p->ns = bench_now_ns() - start;
+    return NULL;
+}
+
+static void bench_contention(void)
+{
+    const uint32_t lines = quick ? 5000 : 100000;
+    producer_t producers[8];
+    tracelib_stats_t stats;
+
+    printf("\nContention, %u lines per thread, instant UART\n  %8s %10s %10s %8s %8s\n", lines,
+           "threads", "ns/line", "lines/s", "retries", "dropped");
+    for (uint32_t threads = 1; threads <= 8; threads *= 2) {
+        uint64_t total_ns = 0;
+        uint64_t slowest_ns = 0;
+
+        output_reset(0);
+        producers_go = false;
+        for (uint32_t i = 0; i < threads; i++) {
+            producers[i] = (producer_t) { .id = i, .lines = lines };
+            pthread_create(&producers[i].thread, NULL, producer, &producers[i]);
+        }
+        producers_go = true;
+        for (uint32_t i = 0; i < threads; i++) {
+            pthread_join(producers[i].thread, NULL);
+            total_ns += producers[i].ns;
+            slowest_ns = producers[i].ns > slowest_ns ? producers[i].ns : slowest_ns;
+        }
+        tracelib_flush();
+        tracelib_get_stats(&stats);
+
+        const uint32_t all = threads * lines;
+        printf("  %8u %10.0f %10.0f %8u %7.1f%%\n", threads, (double)total_ns / all,
+               all / (slowest_ns / 1e9), stats.retries,
+               100.0 * stats.dropped_bytes / (stats.dropped_bytes + stats.sent_bytes));
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    quick = argc > 1 && strcmp(argv[1], "--quick") == 0;
+
+    if (tracelib_init("[B] ", NULL) != 0) {
+        printf("tracelib_init failed\n");
+        return 1;
+    }
+    host_usart_set_capture(UART, false);
+
+    bench_latency();
+    bench_throughput();
+    bench_drop_rate();
+    bench_contention();
+    bench_printf_modes();
+    bench_encode();
+    return 0;
+}
@@ -38,7 +38,9 @@
 #include CMSIS_device_header
 
 #include "uart_tracelib.h"
+#include "retarget.h"
 #include "fault_handler.h"
+#include "alifs_profile.h"
 
 #define UNUSED(x) (void)(x)
 
@@ -108,30 +110,13 @@ const char __stdin_name[] __attribute__((aligned(4)))  = "STDIN";
 const char __stdout_name[] __attribute__((aligned(4))) = "STDOUT";
 const char __stderr_name[] __attribute__((aligned(4))) = "STDERR";
 
-#define RETARGET_BUF_MAX 128
-static char retarget_buf[RETARGET_BUF_MAX];
-static uint32_t retarget_buf_len = 0;
-
 #ifndef A32
 static _Atomic clock_t clock_ticks;
 #endif
 
 void flush_uart()
 {
-    if (retarget_buf_len != 0)
-    {
-        send_str(retarget_buf, retarget_buf_len);
-        retarget_buf_len = 0;
-    }
-}
-
-__STATIC_FORCEINLINE uint32_t in_interrupt(void)
-{
-#ifdef A32
-    return (__get_mode() == CPSR_M_IRQ || __get_mode() == CPSR_M_FIQ);
-#else
-    return __get_IPSR() != 0U;
-#endif
+    tracelib_process();
 }
 
 #if __ICCARM__
@@ -225,24 +210,11 @@ int RETARGET(_read)(FILEHANDLE fh, unsigned char *buf, unsigned int len, int mod
 
     switch (fh) {
     case STDIN: {
-        int c;
-        unsigned int read = 0;
-        bool eof = false;
-
-        while (read < len) {
-
-            /* NOTE: stdin functionality has not been implemented
-                     If stdin is needed: read character from UART here */
-            c = -1;
-
-            if (c == EOF) {
-                eof = true;
-                break;
-            }
-
-            *buf++ = (unsigned char)c;
-            read++;
-        }
+        // wait for input and return what has been received so far,
+        // the stdio line buffering assembles lines for fgets and scanf
+        int ret = tracelib_read((char *)buf, len, TRACELIB_WAIT_FOREVER);
+        unsigned int read = ret > 0 ? ret : 0;
+        bool eof = ret < 0;
 
 #ifdef __ARMCC_VERSION
         /* Return number of bytes not read, combined with an EOF flag */
@@ -275,41 +247,30 @@ int RETARGET(_write)(FILEHANDLE fh, const unsigned char *buf, unsigned int len,
     switch (fh) {
     case STDOUT:
     case STDERR: {
-        bool irqs_disabled = __get_PRIMASK() != 0;
-        if((in_interrupt() || irqs_disabled) && !in_fault_handler())
+        unsigned int written;
+
+        if (in_fault_handler())
         {
-           // this is ISR context or IRQs are disabled so don't push to UART as send_str will
-           // synchronously wait for the tranmission to complete before returning
-           if(retarget_buf_len < RETARGET_BUF_MAX)
-           {
-               // if we're full just drop
-               if (len > RETARGET_BUF_MAX - retarget_buf_len) {
-                   len = RETARGET_BUF_MAX - retarget_buf_len;
-               }
-               memcpy(retarget_buf + retarget_buf_len, buf, len);
-               retarget_buf_len += len;
-           }
+            // The interrupted context may hold the transmitter or an open ring
+            // reservation and the USART interrupts may never come, so the fault
+            // dump bypasses the ring and is sent with polling.
+            tracelib_send_polled((const char *) buf, len);
+            written = len;
         }
         else
         {
-            flush_uart();
-            int ret;
-            do
-            {
-                ret = send_str((const char *) buf, len);
-                // If fault handler is hit while printing was ongoing,
-                // we need to wait here until it's done before we
-                // go on printing fault handler stuff to not lose
-                // most of the fault handler prints.
-            } while (ret != ARM_DRIVER_OK && in_fault_handler());
+            // Threads wait for room in the lock-free tracelib transmit ring,
+            // ISRs and code with interrupts disabled can not and output that
+            // does not fit is dropped. The short count tells stdio.
+            written = tracelib_write((const char *) buf, len, TRACELIB_WAIT_FOREVER);
         }
 
 #ifdef __ARMCC_VERSION
         // armcc expects to get the amount of characters that were not written
-        return 0;
+        return len - written;
 #else
         // GCC AND IAR builds expect to get the amount of characters written
-        return len;
+        return written;
 #endif
     }
     default:
@@ -354,29 +315,12 @@ void _clock_init(void) {}
 // We don't want automatically init systick but call it manually if needed.
 #ifdef A32
 
-// CMSIS version 6.0.0 introduces these
-#if __CM_CMSIS_VERSION_MAIN < 6
-__STATIC_FORCEINLINE uint32_t __get_CNTFRQ(void)
-{
-  uint32_t result;
-  __get_CP(15, 0, result, 14, 0, 0);
-  return result;
-}
-
-__STATIC_FORCEINLINE uint64_t __get_CNTPCT(void)
-{
-  uint64_t result;
-  __get_CP64(15, 1, result, 14);
-  return result;
-}
-#endif
-
 static uint64_t clock_epoch_start;
 
 void clk_init()
 {
     // We assume the counter is started at system init
-    clock_epoch_start = __get_CNTPCT();
+    clock_epoch_start = alifs_profile_cntpct();
 }
 
 void clk_uninit()
@@ -385,7 +329,7 @@ void clk_uninit()
 
 clock_t clock(void)
 {
-    return (__get_CNTPCT() - clock_epoch_start) / (__get_CNTFRQ() / CLOCKS_PER_SEC);
+    return (alifs_profile_cntpct() - clock_epoch_start) / (alifs_profile_cntfrq() / CLOCKS_PER_SEC);
 }
 #else
 void clk_init()
@@ -409,6 +353,9 @@ clock_t clock(void)
 void SysTick_Handler(void)
 {
     clock_ticks++;
+#if defined(RETARGET_PROFILE_EXTEND)
+    alifs_profile_extend();
+#endif
 }
 #endif // !defined(DISABLE_COMMON_APP_SYSTICK)
 #endif // A32
@@ -428,20 +375,170 @@ int rename(const char *oldn, const char *newn)
     return 0;
 }
 
+#ifndef RETARGET_STDOUT_BUFFER_SIZE
+#define RETARGET_STDOUT_BUFFER_SIZE 128
+#endif
+
+void retarget_flush_stdout(void)
+{
+    fflush(stdout);
+}
+
+#if defined(RETARGET_TRACELIB_PRINTF)
+
+// printf through the tracelib formatter, keeps the C library formatter (and
+// its reentrancy and heap use) out of the image
+#ifndef RETARGET_PRINTF_BUFFER_SIZE
+#define RETARGET_PRINTF_BUFFER_SIZE 256
+#endif
+
+static void printf_write(const char *data, size_t len, void *ctx)
+{
+    (void)ctx;
+    fwrite(data, 1, len, stdout);
+}
+
+// formatted in RETARGET_PRINTF_BUFFER_SIZE pieces, long output is not cut
+int vprintf(const char *format, va_list args)
+{
+    char buf[RETARGET_PRINTF_BUFFER_SIZE];
+    return tracelib_vformat(printf_write, NULL, buf, sizeof(buf), format, args);
+}
+
+int printf(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    const int len = vprintf(format, args);
+    va_end(args);
+    return len;
+}
+
+#endif // RETARGET_TRACELIB_PRINTF
+
 #if defined(__clang__) && !defined(__ARMCC_VERSION)
 
 // Picolibc retarget
 // https://github.com/picolibc/picolibc/blob/main/doc/os.md#system-interfaces-used-by-picolibc
 
-static int clang_putc(char c, FILE* file)
+// Picolibc tiny stdio has no buffering of its own, every character goes
+// through put. Collect them here and hand whole lines (or buffers) to _write.
+static char stdout_buf[RETARGET_STDOUT_BUFFER_SIZE];
+static unsigned int stdout_len;
+static int stdout_mode = _IOLBF;
+
+__STATIC_FORCEINLINE uint32_t in_interrupt(void)
+{
+#ifdef A32
+    return (__get_mode() == CPSR_M_IRQ || __get_mode() == CPSR_M_FIQ);
+#else
+    return __get_IPSR() != 0U;
+#endif
+}
+
+// Threads share the buffer, it is only touched with interrupts disabled
+static inline uint32_t stdout_lock(void)
+{
+#ifdef A32
+    const uint32_t cpsr = __get_CPSR();
+    __disable_irq();
+    return cpsr & CPSR_I_Msk;
+#else
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    return primask;
+#endif
+}
+
+static inline void stdout_unlock(uint32_t state)
+{
+    if (state == 0) {
+        __enable_irq();
+    }
+}
+
+static int clang_flush(FILE* file)
 {
+    // copy the buffer out so that _write, which may wait for the UART, runs
+    // with interrupts enabled
+    char line[RETARGET_STDOUT_BUFFER_SIZE];
     (void)file;
+
+    const uint32_t state = stdout_lock();
+    const unsigned int len = stdout_len;
+    memcpy(line, stdout_buf, len);
+    stdout_len = 0;
+    stdout_unlock(state);
+
+    if (len) {
+        _write(STDOUT, (const unsigned char*)line, len, 0);
+    }
+    return 0;
+}
+
+static int clang_putc(char c, FILE* file)
+{
+    if (in_fault_handler()) {
+        // the interrupted thread will not continue, send its partial line first
+        clang_flush(file);
+    } else if (stdout_mode != _IONBF && !in_interrupt()) {
+        // interrupts bypass the buffer instead of corrupting a line in progress
+        bool flush;
+        for (;;) {
+            const uint32_t state = stdout_lock();
+            if (stdout_len < sizeof(stdout_buf)) {
+                stdout_buf[stdout_len++] = c;
+                flush = stdout_len >= sizeof(stdout_buf) || (c == '\n' && stdout_mode == _IOLBF);
+                stdout_unlock(state);
+                break;
+            }
+            // another thread filled the buffer and has not sent it yet
+            stdout_unlock(state);
+            clang_flush(file);
+        }
+        if (flush) {
+            clang_flush(file);
+        }
+        return (unsigned char)c;
+    }
     _write(STDOUT, (const unsigned char*)&c, 1, 0);
-    return c;
+    return (unsigned char)c;
+}
+
+static int clang_putc_unbuffered(char c, FILE* file)
+{
+    (void)file;
+    _write(STDERR, (const unsigned char*)&c, 1, 0);
+    return (unsigned char)c;
 }
 
-static FILE __stdio = FDEV_SETUP_STREAM(clang_putc, 0, 0, _FDEV_SETUP_WRITE);
-FILE *const stdin = &__stdio; __strong_reference(stdin, stdout); __strong_reference(stdin, stderr);
+static int clang_getc(FILE* file)
+{
+    unsigned char c;
+    (void)file;
+    return _read(STDIN, &c, 1, 0) == 1 ? c : EOF;
+}
+
+static FILE __stdio = FDEV_SETUP_STREAM(clang_putc, clang_getc, clang_flush, _FDEV_SETUP_RW);
+static FILE __stderr = FDEV_SETUP_STREAM(clang_putc_unbuffered, 0, 0, _FDEV_SETUP_WRITE);
+FILE *const stdin = &__stdio; __strong_reference(stdin, stdout);
+FILE *const stderr = &__stderr;
+
+int retarget_set_stdout_mode(int mode)
+{
+    clang_flush(stdout);
+    stdout_mode = mode;
+    return 0;
+}
+#else
+
+// The C library buffers stdout itself, only the mode and size are set here.
+// Must be called before anything is written to stdout.
+int retarget_set_stdout_mode(int mode)
+{
+    static char stdout_buf[RETARGET_STDOUT_BUFFER_SIZE];
+    return setvbuf(stdout, mode == _IONBF ? NULL : stdout_buf, mode, sizeof(stdout_buf));
+}
 
 #endif
 
@@ -0,0 +1,55 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+/*
+ * Control of the printf retarget (retarget.c), which hands stdout and stderr
+ * to tracelib.
+ *
+ * Define RETARGET_TRACELIB_PRINTF to format printf and vprintf with the
+ * tracelib formatter instead of the C library. The output is formatted in
+ * RETARGET_PRINTF_BUFFER_SIZE (256) byte pieces on the stack, longer output
+ * is written piece by piece and not truncated.
+ *
+ * Define RETARGET_PROFILE_EXTEND to let the SysTick handler of the M55 cores
+ * keep the 64-bit cycle count of alifs_profile.c up to date, the build then
+ * needs profiling/alifs_profile.c.
+ */
+
+#ifndef RETARGET_H_
+#define RETARGET_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Set the buffering of stdout in the printf retarget (retarget.c).
+ *
+ * Line buffering is the default with picolibc, which has no stdio buffer of
+ * its own, so the retarget keeps a RETARGET_STDOUT_BUFFER_SIZE byte buffer.
+ * With the other C libraries this is setvbuf on stdout with a buffer of the
+ * same size and has to be called before anything is printed. stderr is
+ * not buffered.
+ *
+ * @param mode _IONBF, _IOLBF or _IOFBF from stdio.h
+ * @return 0 on success
+ */
+int retarget_set_stdout_mode(int mode);
+
+/**
+ * @brief Hand the buffered stdout output to tracelib, same as fflush(stdout).
+ */
+void retarget_flush_stdout(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RETARGET_H_ */
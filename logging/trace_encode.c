@@ -0,0 +1,136 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+#include <string.h>
+
+#include "trace_encode.h"
+
+#if defined(__ARM_FEATURE_MVE) && (__ARM_FEATURE_MVE & 1)
+#include <arm_mve.h>
+#define TRACE_ENCODE_MVE
+#endif
+
+static const char hex_digits[16] = "0123456789ABCDEF";
+
+static const char dec_pairs[200] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static inline char printable(uint8_t c)
+{
+    return (uint8_t)(c - ' ') < 95 ? (char)c : '.';
+}
+
+#if defined(TRACE_ENCODE_MVE)
+
+static inline uint8x16_t mve_hex_digits(uint8x16_t nibbles)
+{
+    const uint8x16_t ascii = vaddq_n_u8(nibbles, '0');
+    return vaddq_m_n_u8(ascii, ascii, 'A' - '0' - 10, vcmphiq_n_u8(nibbles, 9));
+}
+
+// 16 bytes to 32 characters, high nibble first
+static inline void mve_hex_block(char *dst, uint8x16_t bytes)
+{
+    uint8x16x2_t out;
+    out.val[0] = mve_hex_digits(vshrq_n_u8(bytes, 4));
+    out.val[1] = mve_hex_digits(vandq_u8(bytes, vdupq_n_u8(0xF)));
+    vst2q_u8((uint8_t *)dst, out);
+}
+
+#endif
+
+void trace_encode_hex8(char *dst, const void *src, uint32_t len)
+{
+    const uint8_t *bytes = (const uint8_t *)src;
+
+#if defined(TRACE_ENCODE_MVE)
+    for (; len >= 16; len -= 16) {
+        mve_hex_block(dst, vld1q_u8(bytes));
+        bytes += 16;
+        dst += 32;
+    }
+#endif
+    while (len--) {
+        const uint8_t b = *bytes++;
+        *dst++ = hex_digits[b >> 4];
+        *dst++ = hex_digits[b & 0xF];
+    }
+}
+
+void trace_encode_hex32(char *dst, const uint32_t *src, uint32_t count)
+{
+#if defined(TRACE_ENCODE_MVE)
+    // byte swap the little endian words so the most significant digit is first
+    for (; count >= 4; count -= 4) {
+        mve_hex_block(dst, vrev32q_u8(vld1q_u8((const uint8_t *)src)));
+        src += 4;
+        dst += 32;
+    }
+#endif
+    while (count--) {
+        const uint32_t word = *src++;
+        for (int shift = 28; shift >= 0; shift -= 4) {
+            *dst++ = hex_digits[(word >> shift) & 0xF];
+        }
+    }
+}
+
+uint32_t trace_encode_dec32(char *dst, uint32_t value)
+{
+    char digits[10];
+    char *p = digits + sizeof(digits);
+
+    // two digits per division
+    while (value >= 100) {
+        const uint32_t pair = value % 100;
+        value /= 100;
+        p -= 2;
+        memcpy(p, &dec_pairs[pair * 2], 2);
+    }
+    if (value >= 10) {
+        p -= 2;
+        memcpy(p, &dec_pairs[value * 2], 2);
+    } else {
+        *--p = '0' + value;
+    }
+
+    const uint32_t len = digits + sizeof(digits) - p;
+    memcpy(dst, p, len);
+    return len;
+}
+
+void trace_encode_ascii(char *dst, const void *src, uint32_t len)
+{
+    const uint8_t *bytes = (const uint8_t *)src;
+
+#if defined(TRACE_ENCODE_MVE)
+    const uint8x16_t dots = vdupq_n_u8('.');
+    for (; len >= 16; len -= 16) {
+        const uint8x16_t v = vld1q_u8(bytes);
+        // printable is 32..126, i.e. c - 32 < 95 unsigned
+        const mve_pred16_t keep = vcmphiq_u8(vdupq_n_u8(95), vsubq_n_u8(v, ' '));
+        vst1q_u8((uint8_t *)dst, vpselq_u8(v, dots, keep));
+        bytes += 16;
+        dst += 16;
+    }
+#endif
+    while (len--) {
+        *dst++ = printable(*bytes++);
+    }
+}
@@ -0,0 +1,55 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+/*
+ * Text encoding kernels for hex dumps, shared by tracelib_dump and the fault
+ * handler. None of them write a terminating zero. The hex and ASCII kernels
+ * use Helium (MVE) on the M55 cores for every full 16-byte block and the
+ * portable code for the rest, the output is the same either way.
+ */
+
+#ifndef TRACE_ENCODE_H_
+#define TRACE_ENCODE_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Encode bytes in memory order as uppercase hex, 2 * len characters.
+ */
+void trace_encode_hex8(char *dst, const void *src, uint32_t len);
+
+/**
+ * @brief Encode 32-bit words as 8 uppercase hex digits each, 8 * count
+ *        characters without separators, like "%08X" for every word.
+ */
+void trace_encode_hex32(char *dst, const uint32_t *src, uint32_t count);
+
+/**
+ * @brief Encode value in decimal, like "%u".
+ *
+ * @return number of characters written, at most 10
+ */
+uint32_t trace_encode_dec32(char *dst, uint32_t value);
+
+/**
+ * @brief Copy printable ASCII characters and replace the rest with '.',
+ *        len characters.
+ */
+void trace_encode_ascii(char *dst, const void *src, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TRACE_ENCODE_H_ */
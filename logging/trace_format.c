@@ -0,0 +1,783 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+/*
+ * Small printf style formatter used by tracef instead of the C library.
+ *
+ * Everything is formatted straight into the destination buffer, there is no
+ * heap use, no locking and no reentrancy state, so it is safe from any context.
+ * The stack use is bounded by a single number conversion buffer, and for
+ * floating point the bignum that holds the exact value while rounding.
+ *
+ * Supported: flags "-+ #0", width and precision (also '*'), length modifiers
+ * hh h l ll j z t L and the conversions d i u o x X c s p n % f F e E g G.
+ * Floating point output has at most TRACE_FORMAT_FLOAT_PREC fractional digits
+ * and %f switches to %e style for values beyond the 64-bit integer range.
+ * Unknown conversions are copied to the output as is.
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "uart_tracelib.h"
+
+#define TRACE_FORMAT_FLOAT_PREC 9
+
+#define FLAG_LEFT   (1U << 0)
+#define FLAG_PLUS   (1U << 1)
+#define FLAG_SPACE  (1U << 2)
+#define FLAG_ALT    (1U << 3)
+#define FLAG_ZERO   (1U << 4)
+#define FLAG_UPPER  (1U << 5)
+
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t len;
+    tracelib_format_write_t write;  // hands over full buffers, see tracelib_vformat
+    void *ctx;
+    size_t written;                 // output already handed to write
+} fmt_out_t;
+
+typedef struct {
+    uint32_t flags;
+    int width;
+    int prec;       // -1 when not given
+} fmt_spec_t;
+
+// longest conversion: 22 octal digits of a 64-bit value, or a float with
+// 20 integer digits, the point and the fractional digits
+#define FMT_NUM_SIZE 32
+
+static const uint64_t pow10_table[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+    10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL
+};
+
+static void out_flush(fmt_out_t *out)
+{
+    out->write(out->buf, out->len, out->ctx);
+    out->written += out->len;
+    out->len = 0;
+}
+
+static inline void out_char(fmt_out_t *out, char c)
+{
+    if (out->len + 1 >= out->size && out->write) {
+        out_flush(out);
+    }
+    if (out->len + 1 < out->size) {
+        out->buf[out->len] = c;
+    }
+    out->len++;
+}
+
+static void out_str(fmt_out_t *out, const char *str, size_t len)
+{
+    while (out->write && out->len + 1 + len > out->size) {
+        const size_t room = out->size - 1 - out->len;
+        memcpy(&out->buf[out->len], str, room);
+        out->len += room;
+        str += room;
+        len -= room;
+        out_flush(out);
+    }
+    if (out->len + 1 < out->size) {
+        const size_t room = out->size - 1 - out->len;
+        memcpy(&out->buf[out->len], str, len < room ? len : room);
+    }
+    out->len += len;
+}
+
+static void out_repeat(fmt_out_t *out, char c, int count)
+{
+    while (count-- > 0) {
+        out_char(out, c);
+    }
+}
+
+/*
+ * Write prefix, zeros and body padded to the field width.
+ */
+static void out_field(fmt_out_t *out, const fmt_spec_t *spec, const char *prefix, uint32_t prefix_len,
+                      uint32_t zeros, const char *body, uint32_t body_len)
+{
+    const int pad = spec->width - (int)(prefix_len + zeros + body_len);
+
+    if ((spec->flags & (FLAG_LEFT | FLAG_ZERO)) == 0) {
+        out_repeat(out, ' ', pad);
+    }
+    out_str(out, prefix, prefix_len);
+    if ((spec->flags & (FLAG_LEFT | FLAG_ZERO)) == FLAG_ZERO) {
+        out_repeat(out, '0', pad);
+    }
+    out_repeat(out, '0', zeros);
+    out_str(out, body, body_len);
+    if (spec->flags & FLAG_LEFT) {
+        out_repeat(out, ' ', pad);
+    }
+}
+
+/*
+ * Convert value to digits ending at end. Values that fit 32 bits are
+ * converted with 32-bit arithmetic, the M55 has no 64-bit divide.
+ *
+ * @return number of digits
+ */
+static uint32_t utoa_rev(char *end, uint64_t value, uint32_t base, bool upper)
+{
+    const char *digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    char *p = end;
+
+    if (base == 10) {
+        while (value > UINT32_MAX) {
+            *--p = digits[value % 10];
+            value /= 10;
+        }
+        uint32_t v = (uint32_t)value;
+        do {
+            *--p = digits[v % 10];
+            v /= 10;
+        } while (v);
+    } else {
+        const uint32_t shift = base == 16 ? 4 : 3;
+        do {
+            *--p = digits[value & (base - 1)];
+            value >>= shift;
+        } while (value);
+    }
+    return end - p;
+}
+
+static void format_int(fmt_out_t *out, fmt_spec_t *spec, uint64_t value, bool negative, uint32_t base)
+{
+    char num[FMT_NUM_SIZE];
+    char prefix[2];
+    uint32_t prefix_len = 0;
+    uint32_t len = 0;
+
+    if (negative) {
+        prefix[prefix_len++] = '-';
+    } else if (base == 10 && (spec->flags & FLAG_PLUS)) {
+        prefix[prefix_len++] = '+';
+    } else if (base == 10 && (spec->flags & FLAG_SPACE)) {
+        prefix[prefix_len++] = ' ';
+    }
+
+    if (value != 0 || spec->prec != 0) {
+        len = utoa_rev(num + sizeof(num), value, base, spec->flags & FLAG_UPPER);
+    }
+
+    if (spec->flags & FLAG_ALT) {
+        if (base == 16 && value != 0) {
+            prefix[prefix_len++] = '0';
+            prefix[prefix_len++] = (spec->flags & FLAG_UPPER) ? 'X' : 'x';
+        } else if (base == 8 && (len == 0 || num[sizeof(num) - len] != '0') && (int)len >= spec->prec) {
+            num[sizeof(num) - ++len] = '0';
+        }
+    }
+
+    uint32_t zeros = 0;
+    if (spec->prec >= 0) {
+        spec->flags &= ~FLAG_ZERO;
+        if ((uint32_t)spec->prec > len) {
+            zeros = spec->prec - len;
+        }
+    }
+    out_field(out, spec, prefix, prefix_len, zeros, num + sizeof(num) - len, len);
+}
+
+/*
+ * Exact decimal rounding. A finite double is m * 2^e with an integer m below
+ * 2^53, so value * 10^scale is a fraction of integers that a small bignum
+ * holds exactly, at most 2^53 * 10^334 for the smallest subnormal. Values are
+ * rounded once, half to even, on their exact digits like the C library.
+ */
+#define FMT_BIG_WORDS 37
+
+#define ROUND_EXACT 0   // nothing dropped
+#define ROUND_BELOW 1   // dropped part below one half
+#define ROUND_HALF  2   // exactly one half
+#define ROUND_ABOVE 3
+
+typedef struct {
+    uint32_t len;
+    uint32_t word[FMT_BIG_WORDS];   // little endian, no leading zero words
+} fmt_big_t;
+
+static void big_trim(fmt_big_t *big)
+{
+    while (big->len && big->word[big->len - 1] == 0) {
+        big->len--;
+    }
+}
+
+static void big_mul(fmt_big_t *big, uint32_t factor)
+{
+    uint64_t carry = 0;
+
+    for (uint32_t i = 0; i < big->len; i++) {
+        carry += (uint64_t)big->word[i] * factor;
+        big->word[i] = (uint32_t)carry;
+        carry >>= 32;
+    }
+    if (carry) {
+        big->word[big->len++] = (uint32_t)carry;
+    }
+}
+
+/*
+ * @return the remainder
+ */
+static uint32_t big_div(fmt_big_t *big, uint32_t divisor)
+{
+    uint64_t rem = 0;
+
+    for (uint32_t i = big->len; i-- > 0;) {
+        rem = rem << 32 | big->word[i];
+        big->word[i] = (uint32_t)(rem / divisor);
+        rem %= divisor;
+    }
+    big_trim(big);
+    return (uint32_t)rem;
+}
+
+static void big_shl(fmt_big_t *big, uint32_t bits)
+{
+    const uint32_t words = bits / 32;
+    const uint32_t shift = bits % 32;
+
+    if (big->len == 0) {
+        return;
+    }
+    big->word[big->len] = 0;
+    for (uint32_t i = big->len + 1; i-- > 0;) {
+        const uint32_t low = shift && i ? big->word[i - 1] >> (32 - shift) : 0;
+        big->word[i + words] = big->word[i] << shift | low;
+    }
+    memset(big->word, 0, words * sizeof(big->word[0]));
+    big->len += words + 1;
+    big_trim(big);
+}
+
+/*
+ * @return ROUND_EXACT, ROUND_BELOW, ROUND_HALF or ROUND_ABOVE for the bits
+ *         shifted out
+ */
+static uint32_t big_shr(fmt_big_t *big, uint32_t bits)
+{
+    const uint32_t words = bits / 32;
+    const uint32_t shift = bits % 32;
+    const uint32_t top = bits - 1;
+    bool half = false;
+    bool rest = false;
+
+    if (bits == 0) {
+        return ROUND_EXACT;
+    }
+    for (uint32_t i = 0; i < top / 32 && i < big->len; i++) {
+        rest |= big->word[i] != 0;
+    }
+    if (top / 32 < big->len) {
+        half = (big->word[top / 32] >> (top % 32)) & 1;
+        rest |= (big->word[top / 32] & ((1U << (top % 32)) - 1)) != 0;
+    }
+
+    if (words >= big->len) {
+        big->len = 0;
+    } else {
+        for (uint32_t i = 0; i < big->len - words; i++) {
+            const uint32_t high = shift && i + words + 1 < big->len ?
+                                  big->word[i + words + 1] << (32 - shift) : 0;
+            big->word[i] = big->word[i + words] >> shift | high;
+        }
+        big->len -= words;
+        big_trim(big);
+    }
+    if (half) {
+        return rest ? ROUND_ABOVE : ROUND_HALF;
+    }
+    return rest ? ROUND_BELOW : ROUND_EXACT;
+}
+
+/*
+ * Divide by 10^exp. below is the class of a binary fraction dropped before,
+ * which is smaller than any decimal remainder and only breaks ties.
+ */
+static uint32_t big_div_pow10(fmt_big_t *big, uint32_t exp, uint32_t below)
+{
+    bool rest = below != ROUND_EXACT;
+
+    if (exp == 0) {
+        return below;
+    }
+    for (; exp > 9; exp -= 9) {
+        rest |= big_div(big, 1000000000U) != 0;
+    }
+    const uint32_t rem = big_div(big, (uint32_t)pow10_table[exp]);
+    const uint32_t half = 5 * (uint32_t)pow10_table[exp - 1];
+    if (rem != half) {
+        return rem > half ? ROUND_ABOVE : (rem || rest ? ROUND_BELOW : ROUND_EXACT);
+    }
+    return rest ? ROUND_ABOVE : ROUND_HALF;
+}
+
+/*
+ * Split a finite non-negative value into m * 2^e.
+ *
+ * @return e
+ */
+static int decompose(double value, uint64_t *m)
+{
+    uint64_t bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+    const uint32_t biased = (uint32_t)(bits >> 52) & 0x7FFU;
+    *m = bits & ((1ULL << 52) - 1);
+    if (biased == 0) {
+        return -1074;
+    }
+    *m |= 1ULL << 52;
+    return (int)biased - 1075;
+}
+
+/*
+ * floor(m * 2^e * 10^scale), the result must be below 2^64.
+ *
+ * @param round class of the dropped fraction, see ROUND_EXACT
+ */
+static uint64_t scale_exact(uint64_t m, int e, int scale, uint32_t *round)
+{
+    fmt_big_t big = { 0 };
+
+    big.word[big.len++] = (uint32_t)m;
+    big.word[big.len++] = (uint32_t)(m >> 32);
+    big_trim(&big);
+    if (e > 0) {
+        big_shl(&big, (uint32_t)e);
+    }
+    for (int exp = scale; exp > 0; exp -= 9) {
+        big_mul(&big, (uint32_t)pow10_table[exp > 9 ? 9 : exp]);
+    }
+    *round = e < 0 ? big_shr(&big, (uint32_t)-e) : ROUND_EXACT;
+    if (scale < 0) {
+        *round = big_div_pow10(&big, (uint32_t)-scale, *round);
+    }
+    return (uint64_t)(big.len > 1 ? big.word[1] : 0) << 32 | (big.len ? big.word[0] : 0);
+}
+
+static inline bool round_up(uint32_t round, uint64_t last)
+{
+    return round == ROUND_ABOVE || (round == ROUND_HALF && (last & 1));
+}
+
+/*
+ * Write prec fractional digits of frac, which is below pow10_table[prec].
+ */
+static uint32_t put_fraction(char *buf, uint32_t frac, uint32_t prec, bool point)
+{
+    uint32_t len = 0;
+
+    if (prec || point) {
+        buf[len++] = '.';
+    }
+    for (uint32_t i = prec; i > 0; i--) {
+        buf[len + i - 1] = '0' + frac % 10;
+        frac /= 10;
+    }
+    return len + prec;
+}
+
+/*
+ * %f of a non-negative value below 2^64.
+ */
+static uint32_t put_fixed(char *buf, double value, uint32_t prec, bool point)
+{
+    uint64_t m;
+    const int e = decompose(value, &m);
+    uint64_t ipart = 0;
+    uint64_t frac = 0;
+    uint32_t round = ROUND_EXACT;
+    char digits[20];
+
+    if (e >= 0) {
+        ipart = m << e;
+    } else if (e > -64) {
+        ipart = m >> -e;
+        frac = scale_exact(m & ((1ULL << -e) - 1), e, (int)prec, &round);
+    } else {
+        frac = scale_exact(m, e, (int)prec, &round);
+    }
+    // the last digit is the one of the integer part without a fraction
+    if (round_up(round, prec ? frac : ipart)) {
+        frac++;
+    }
+    if (frac >= pow10_table[prec]) {
+        frac -= pow10_table[prec];
+        ipart++;
+    }
+    const uint32_t len = utoa_rev(digits + sizeof(digits), ipart, 10, false);
+    memcpy(buf, digits + sizeof(digits) - len, len);
+    return len + put_fraction(buf + len, (uint32_t)frac, prec, point);
+}
+
+/*
+ * Round a non-negative value to prec + 1 significant digits.
+ *
+ * @return the digits as integer, exp is set to the decimal exponent
+ */
+static uint64_t round_digits(double value, uint32_t prec, int *exp)
+{
+    uint64_t m;
+    const int e = decompose(value, &m);
+    uint32_t round;
+
+    if (m == 0) {
+        *exp = 0;
+        return 0;
+    }
+    // floor(log2(value) * log10(2)) is the decimal exponent or one below it
+    int exp2 = e + 52;
+    for (uint64_t top = m; top < (1ULL << 52); top <<= 1) {
+        exp2--;
+    }
+    int exp10 = exp2 >= 0 ? (exp2 * 78913) >> 18 : -((-exp2 * 78913 + (1 << 18) - 1) >> 18);
+    uint64_t digits = scale_exact(m, e, (int)prec - exp10, &round);
+    if (digits >= pow10_table[prec + 1]) {
+        exp10++;
+        digits = scale_exact(m, e, (int)prec - exp10, &round);
+    }
+    if (round_up(round, digits)) {
+        digits++;
+    }
+    if (digits >= pow10_table[prec + 1]) {
+        digits /= 10;
+        exp10++;
+    }
+    *exp = exp10;
+    return digits;
+}
+
+/*
+ * %e of a non-negative value.
+ */
+static uint32_t put_exp(char *buf, double value, uint32_t prec, bool point, bool upper)
+{
+    int exp;
+    const uint64_t digits = round_digits(value, prec, &exp);
+    uint32_t len = 0;
+
+    buf[len++] = '0' + (uint32_t)(digits / pow10_table[prec]);
+    len += put_fraction(buf + len, (uint32_t)(digits % pow10_table[prec]), prec, point);
+
+    buf[len++] = upper ? 'E' : 'e';
+    buf[len++] = exp < 0 ? '-' : '+';
+    if (exp < 0) {
+        exp = -exp;
+    }
+    if (exp >= 100) {
+        buf[len++] = '0' + exp / 100;
+    }
+    buf[len++] = '0' + exp / 10 % 10;
+    buf[len++] = '0' + exp % 10;
+    return len;
+}
+
+/*
+ * Remove trailing fractional zeros and a trailing point, keeping an exponent.
+ */
+static uint32_t strip_zeros(char *buf, uint32_t len)
+{
+    uint32_t end = 0;
+
+    while (end < len && buf[end] != '.') {
+        end++;
+    }
+    if (end == len) {
+        return len;
+    }
+
+    uint32_t exp = end;
+    while (exp < len && buf[exp] != 'e' && buf[exp] != 'E') {
+        exp++;
+    }
+    uint32_t last = exp;
+    while (buf[last - 1] == '0') {
+        last--;
+    }
+    if (buf[last - 1] == '.') {
+        last--;
+    }
+    memmove(buf + last, buf + exp, len - exp);
+    return last + len - exp;
+}
+
+static void format_float(fmt_out_t *out, fmt_spec_t *spec, double value, char conv)
+{
+    const bool upper = spec->flags & FLAG_UPPER;
+    const bool point = spec->flags & FLAG_ALT;
+    char num[FMT_NUM_SIZE];
+    char prefix[1];
+    uint32_t prefix_len = 0;
+    uint32_t len;
+
+    if (signbit(value)) {
+        prefix[prefix_len++] = '-';
+        value = -value;
+    } else if (spec->flags & FLAG_PLUS) {
+        prefix[prefix_len++] = '+';
+    } else if (spec->flags & FLAG_SPACE) {
+        prefix[prefix_len++] = ' ';
+    }
+
+    if (!isfinite(value)) {
+        spec->flags &= ~FLAG_ZERO;
+        out_field(out, spec, prefix, prefix_len, 0,
+                  isnan(value) ? (upper ? "NAN" : "nan") : (upper ? "INF" : "inf"), 3);
+        return;
+    }
+
+    uint32_t prec = spec->prec < 0 ? 6 : (uint32_t)spec->prec;
+    if (prec > TRACE_FORMAT_FLOAT_PREC) {
+        prec = TRACE_FORMAT_FLOAT_PREC;
+    }
+
+    if (conv == 'g' || conv == 'G') {
+        // C rules: exponent style unless -4 <= X < P, X being the exponent
+        // after rounding to P significant digits
+        const uint32_t sig = prec ? prec : 1;
+        int exp;
+        (void)round_digits(value, sig - 1, &exp);
+
+        if (exp >= -4 && exp < (int)sig) {
+            uint32_t frac = sig - 1 - exp;
+            len = put_fixed(num, value, frac > TRACE_FORMAT_FLOAT_PREC ? TRACE_FORMAT_FLOAT_PREC : frac, point);
+        } else {
+            len = put_exp(num, value, sig - 1, point, upper);
+        }
+        if (!point) {
+            len = strip_zeros(num, len);
+        }
+    } else if ((conv == 'f' || conv == 'F') && value < 1.8e19) {
+        len = put_fixed(num, value, prec, point);
+    } else {
+        len = put_exp(num, value, prec, point, upper);
+    }
+    out_field(out, spec, prefix, prefix_len, 0, num, len);
+}
+
+static void format_out(fmt_out_t *out, const char *format, va_list args)
+{
+    const char *p = format;
+
+    while (*p) {
+        const char *start = p;
+        while (*p && *p != '%') {
+            p++;
+        }
+        out_str(out, start, p - start);
+        if (*p == '\0') {
+            break;
+        }
+        start = p++;
+
+        fmt_spec_t spec = { 0, 0, -1 };
+        for (;; p++) {
+            if (*p == '-') {
+                spec.flags |= FLAG_LEFT;
+            } else if (*p == '+') {
+                spec.flags |= FLAG_PLUS;
+            } else if (*p == ' ') {
+                spec.flags |= FLAG_SPACE;
+            } else if (*p == '#') {
+                spec.flags |= FLAG_ALT;
+            } else if (*p == '0') {
+                spec.flags |= FLAG_ZERO;
+            } else {
+                break;
+            }
+        }
+
+        if (*p == '*') {
+            spec.width = va_arg(args, int);
+            if (spec.width < 0) {
+                spec.flags |= FLAG_LEFT;
+                spec.width = -spec.width;
+            }
+            p++;
+        }
+        while (*p >= '0' && *p <= '9') {
+            spec.width = spec.width * 10 + (*p++ - '0');
+        }
+        if (*p == '.') {
+            p++;
+            spec.prec = 0;
+            if (*p == '*') {
+                spec.prec = va_arg(args, int);
+                p++;
+            }
+            while (*p >= '0' && *p <= '9') {
+                spec.prec = spec.prec * 10 + (*p++ - '0');
+            }
+        }
+
+        int longs = 0;
+        int shorts = 0;
+        bool long_double = false;
+        for (;; p++) {
+            if (*p == 'l') {
+                longs++;
+            } else if (*p == 'h') {
+                shorts++;
+            } else if (*p == 'j') {
+                longs = 2;
+            } else if (*p == 'z' || *p == 't') {
+                longs = sizeof(size_t) == sizeof(long) ? 1 : 2;
+            } else if (*p == 'L') {
+                long_double = true;
+            } else {
+                break;
+            }
+        }
+
+        const char conv = *p;
+        if (conv == '\0') {
+            out_str(out, start, p - start);
+            break;
+        }
+        p++;
+        if (conv == 'X' || conv == 'E' || conv == 'F' || conv == 'G') {
+            spec.flags |= FLAG_UPPER;
+        }
+
+        switch (conv) {
+        case 'd':
+        case 'i': {
+            long long value;
+            if (longs >= 2) {
+                value = va_arg(args, long long);
+            } else if (longs == 1) {
+                value = va_arg(args, long);
+            } else {
+                value = va_arg(args, int);
+                if (shorts == 1) {
+                    value = (short)value;
+                } else if (shorts >= 2) {
+                    value = (signed char)value;
+                }
+            }
+            format_int(out, &spec, value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value,
+                       value < 0, 10);
+            break;
+        }
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X': {
+            unsigned long long value;
+            if (longs >= 2) {
+                value = va_arg(args, unsigned long long);
+            } else if (longs == 1) {
+                value = va_arg(args, unsigned long);
+            } else {
+                value = va_arg(args, unsigned int);
+                if (shorts == 1) {
+                    value = (unsigned short)value;
+                } else if (shorts >= 2) {
+                    value = (unsigned char)value;
+                }
+            }
+            spec.flags &= ~(FLAG_PLUS | FLAG_SPACE);
+            format_int(out, &spec, value, false, conv == 'u' ? 10 : conv == 'o' ? 8 : 16);
+            break;
+        }
+        case 'p':
+            spec.flags |= FLAG_ALT;
+            format_int(out, &spec, (uintptr_t)va_arg(args, void *), false, 16);
+            break;
+        case 'c': {
+            const char c = (char)va_arg(args, int);
+            spec.flags &= ~FLAG_ZERO;
+            out_field(out, &spec, "", 0, 0, &c, 1);
+            break;
+        }
+        case 's': {
+            const char *str = va_arg(args, const char *);
+            if (str == NULL) {
+                str = "(null)";
+            }
+            size_t len = 0;
+            if (spec.prec >= 0) {
+                while (len < (size_t)spec.prec && str[len]) {
+                    len++;
+                }
+            } else {
+                len = strlen(str);
+            }
+            spec.flags &= ~FLAG_ZERO;
+            out_field(out, &spec, "", 0, 0, str, len);
+            break;
+        }
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+            format_float(out, &spec, long_double ? (double)va_arg(args, long double) : va_arg(args, double), conv);
+            break;
+        case 'n':
+            *va_arg(args, int *) = (int)(out->written + out->len);
+            break;
+        case '%':
+            out_char(out, '%');
+            break;
+        default:
+            // not supported, the argument cannot be skipped safely either
+            out_str(out, start, p - start);
+            break;
+        }
+    }
+
+}
+
+int tracelib_vsnprintf(char *buf, size_t size, const char *format, va_list args)
+{
+    fmt_out_t out = { buf, size, 0, NULL, NULL, 0 };
+
+    format_out(&out, format, args);
+    if (size) {
+        buf[out.len < size ? out.len : size - 1] = '\0';
+    }
+    return (int)out.len;
+}
+
+int tracelib_vformat(tracelib_format_write_t write, void *ctx, char *buf, size_t size,
+                     const char *format, va_list args)
+{
+    fmt_out_t out = { buf, size, 0, write, ctx, 0 };
+
+    format_out(&out, format, args);
+    if (out.len) {
+        out_flush(&out);
+    }
+    return (int)out.written;
+}
+
+int tracelib_snprintf(char *buf, size_t size, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    const int len = tracelib_vsnprintf(buf, size, format, args);
+    va_end(args);
+    return len;
+}
@@ -0,0 +1,188 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+/*
+ * Structured key-value records encoded as CBOR (RFC 8949) maps directly in a
+ * transmit ring reservation, see TRACELIB_KV_RECORD_MARKER in uart_tracelib.h.
+ */
+
+#include <string.h>
+
+#include "uart_tracelib.h"
+
+#define CBOR_UINT       0
+#define CBOR_NINT       1
+#define CBOR_BYTES      2
+#define CBOR_TEXT       3
+#define CBOR_TAG        6
+#define CBOR_FLOAT32    0xFA
+#define CBOR_FLOAT64    0xFB
+#define CBOR_MAP_START  0xBF
+#define CBOR_BREAK      0xFF
+
+#define KV_HDR_SIZE     3   // marker and length
+
+static uint32_t cbor_head_size(uint64_t value)
+{
+    if (value < 24) {
+        return 1;
+    }
+    if (value <= UINT8_MAX) {
+        return 2;
+    }
+    if (value <= UINT16_MAX) {
+        return 3;
+    }
+    return value <= UINT32_MAX ? 5 : 9;
+}
+
+static uint8_t *cbor_head(uint8_t *dst, uint8_t major, uint64_t value)
+{
+    const uint32_t size = cbor_head_size(value);
+    static const uint8_t info[] = { 0, 0, 24, 25, 0, 26, 0, 0, 0, 27 };
+
+    if (size == 1) {
+        *dst++ = (uint8_t)((major << 5) | value);
+        return dst;
+    }
+
+    // big endian argument
+    *dst++ = (uint8_t)((major << 5) | info[size]);
+    for (uint32_t i = size - 1; i > 0; i--) {
+        *dst++ = (uint8_t)(value >> ((i - 1) * 8));
+    }
+    return dst;
+}
+
+/*
+ * Make room for a field, the closing break byte is always kept free.
+ * Fields that do not fit are left out of the record.
+ */
+static uint8_t *kv_field(tracelib_kv_t *kv, const char *key, uint32_t value_size)
+{
+    if (kv->buf == NULL) {
+        return NULL;
+    }
+
+    const uint32_t key_len = strlen(key);
+    const uint32_t need = cbor_head_size(key_len) + key_len + value_size;
+    if (kv->len + need + 1 > kv->res.size) {
+        kv->truncated = true;
+        return NULL;
+    }
+
+    uint8_t *dst = cbor_head(kv->buf + kv->len, CBOR_TEXT, key_len);
+    memcpy(dst, key, key_len);
+    kv->len += need;
+    return dst + key_len;
+}
+
+static void kv_blob(tracelib_kv_t *kv, const char *key, uint8_t major, const void *data, uint32_t len)
+{
+    uint8_t *dst = kv_field(kv, key, cbor_head_size(len) + len);
+    if (dst) {
+        memcpy(cbor_head(dst, major, len), data, len);
+    }
+}
+
+bool tracelib_kv_begin(tracelib_kv_t *kv, const char *event)
+{
+    kv->len = 0;
+    kv->truncated = false;
+    kv->buf = tracelib_reserve(TRACELIB_KV_MAX_LEN, &kv->res);
+    if (kv->buf == NULL) {
+        return false;
+    }
+
+    kv->buf[0] = TRACELIB_KV_RECORD_MARKER;
+    kv->buf[KV_HDR_SIZE] = CBOR_MAP_START;
+    kv->len = KV_HDR_SIZE + 1;
+    tracelib_kv_str(kv, "event", event);
+    tracelib_kv_timestamp(kv, "ts");
+    return true;
+}
+
+void tracelib_kv_int(tracelib_kv_t *kv, const char *key, int64_t value)
+{
+    // negative integers are encoded as -1 - n
+    const uint8_t major = value < 0 ? CBOR_NINT : CBOR_UINT;
+    const uint64_t arg = value < 0 ? (uint64_t)(-1 - value) : (uint64_t)value;
+    uint8_t *dst = kv_field(kv, key, cbor_head_size(arg));
+    if (dst) {
+        cbor_head(dst, major, arg);
+    }
+}
+
+void tracelib_kv_uint(tracelib_kv_t *kv, const char *key, uint64_t value)
+{
+    uint8_t *dst = kv_field(kv, key, cbor_head_size(value));
+    if (dst) {
+        cbor_head(dst, CBOR_UINT, value);
+    }
+}
+
+void tracelib_kv_float(tracelib_kv_t *kv, const char *key, double value)
+{
+    // single precision when no precision is lost
+    const float narrow = (float)value;
+    const bool single = (double)narrow == value || value != value;
+    uint8_t *dst = kv_field(kv, key, single ? 5 : 9);
+    uint64_t bits;
+
+    if (dst == NULL) {
+        return;
+    }
+    if (single) {
+        uint32_t bits32;
+        memcpy(&bits32, &narrow, sizeof(bits32));
+        *dst = CBOR_FLOAT32;
+        for (uint32_t i = 0; i < 4; i++) {
+            dst[1 + i] = (uint8_t)(bits32 >> ((3 - i) * 8));
+        }
+        return;
+    }
+    memcpy(&bits, &value, sizeof(bits));
+    *dst = CBOR_FLOAT64;
+    for (uint32_t i = 0; i < 8; i++) {
+        dst[1 + i] = (uint8_t)(bits >> ((7 - i) * 8));
+    }
+}
+
+void tracelib_kv_str(tracelib_kv_t *kv, const char *key, const char *value)
+{
+    kv_blob(kv, key, CBOR_TEXT, value, strlen(value));
+}
+
+void tracelib_kv_bytes(tracelib_kv_t *kv, const char *key, const void *data, uint32_t len)
+{
+    kv_blob(kv, key, CBOR_BYTES, data, len);
+}
+
+void tracelib_kv_timestamp(tracelib_kv_t *kv, const char *key)
+{
+    const uint32_t now = tracelib_timestamp();
+    uint8_t *dst = kv_field(kv, key, 1 + cbor_head_size(now));
+    if (dst) {
+        cbor_head(cbor_head(dst, CBOR_TAG, TRACELIB_KV_TAG_CYCLES), CBOR_UINT, now);
+    }
+}
+
+void tracelib_kv_end(tracelib_kv_t *kv)
+{
+    if (kv->buf == NULL) {
+        return;
+    }
+
+    kv->buf[kv->len++] = CBOR_BREAK;
+    const uint16_t body_len = kv->len - KV_HDR_SIZE;
+    memcpy(kv->buf + 1, &body_len, sizeof(body_len));
+    tracelib_commit(&kv->res, kv->len);
+    kv->buf = NULL;
+}
@@ -0,0 +1,230 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <RTE_Components.h>
+#include CMSIS_device_header
+
+#include "trace_port.h"
+
+#if TRACELIB_MAX_PORTS > 4
+#error "Add event trampolines for more than 4 ports"
+#endif
+
+static tracelib_port_t *_Atomic ports[TRACELIB_MAX_PORTS];
+
+static void port_event(uint32_t index, uint32_t event)
+{
+    tracelib_port_t *port = atomic_load_explicit(&ports[index], memory_order_acquire);
+    if (port == NULL) {
+        return;
+    }
+
+    if (event & ARM_USART_EVENT_SEND_COMPLETE) {
+        trace_tx_complete(&port->tx);
+    }
+
+    if (port->user_cb) {
+        port->user_cb(event);
+    }
+}
+
+static void port_event_0(uint32_t event) { port_event(0, event); }
+#if TRACELIB_MAX_PORTS > 1
+static void port_event_1(uint32_t event) { port_event(1, event); }
+#endif
+#if TRACELIB_MAX_PORTS > 2
+static void port_event_2(uint32_t event) { port_event(2, event); }
+#endif
+#if TRACELIB_MAX_PORTS > 3
+static void port_event_3(uint32_t event) { port_event(3, event); }
+#endif
+
+static const ARM_USART_SignalEvent_t port_events[TRACELIB_MAX_PORTS] = {
+    port_event_0,
+#if TRACELIB_MAX_PORTS > 1
+    port_event_1,
+#endif
+#if TRACELIB_MAX_PORTS > 2
+    port_event_2,
+#endif
+#if TRACELIB_MAX_PORTS > 3
+    port_event_3,
+#endif
+};
+
+int tracelib_port_init(tracelib_port_t *port, ARM_DRIVER_USART *drv, uint8_t *buf, uint32_t size,
+                       uint32_t baudrate, ARM_USART_SignalEvent_t cb)
+{
+    int32_t ret;
+    uint32_t index;
+
+    // the ring indexes wrap with a mask
+    if (size == 0 || (size & (size - 1)) != 0) {
+        return ARM_DRIVER_ERROR_PARAMETER;
+    }
+
+    memset(buf, 0, size);
+    trace_ring_init(&port->ring, buf, size);
+    trace_tx_init(&port->tx, drv, &port->ring, NULL, TRACELIB_SINK_UART);
+    port->user_cb = cb;
+    tracelib_port_set_prefix(port, NULL);
+
+    for (index = 0; index < TRACELIB_MAX_PORTS; index++) {
+        tracelib_port_t *expected = NULL;
+        if (atomic_compare_exchange_strong(&ports[index], &expected, port)) {
+            break;
+        }
+    }
+    if (index == TRACELIB_MAX_PORTS) {
+        return ARM_DRIVER_ERROR_BUSY;
+    }
+    port->index = index;
+
+    ret = drv->Initialize(port_events[index]);
+    if (ret == ARM_DRIVER_OK) {
+        ret = drv->PowerControl(ARM_POWER_FULL);
+    }
+    if (ret == ARM_DRIVER_OK) {
+        ret = drv->Control(ARM_USART_MODE_ASYNCHRONOUS |
+                           ARM_USART_DATA_BITS_8       |
+                           ARM_USART_PARITY_NONE       |
+                           ARM_USART_STOP_BITS_1       |
+                           ARM_USART_FLOW_CONTROL_NONE, baudrate);
+    }
+    if (ret == ARM_DRIVER_OK) {
+        ret = drv->Control(ARM_USART_CONTROL_TX, 1);
+    }
+    if (ret != ARM_DRIVER_OK) {
+        atomic_store_explicit(&ports[index], NULL, memory_order_release);
+    }
+    return ret;
+}
+
+int tracelib_port_uninit(tracelib_port_t *port)
+{
+    int32_t ret;
+
+    tracelib_port_flush(port);
+    ret = port->tx.drv->PowerControl(ARM_POWER_OFF);
+    if (ret == ARM_DRIVER_OK) {
+        ret = port->tx.drv->Uninitialize();
+    }
+    atomic_store_explicit(&ports[port->index], NULL, memory_order_release);
+    return ret;
+}
+
+int tracelib_port_send(tracelib_port_t *port, const void *data, uint32_t len)
+{
+    const uint8_t *src = data;
+    const uint32_t max_len = port->ring.size / 4 < TRACE_REC_MAX_LEN ? port->ring.size / 4 : TRACE_REC_MAX_LEN;
+    bool queued = false;
+
+    while (len) {
+        const uint32_t chunk = len < max_len ? len : max_len;
+        uint32_t rec;
+        uint8_t *dst = trace_ring_reserve(&port->ring, chunk, &rec);
+        if (dst == NULL) {
+            if (!queued) {
+                return ARM_DRIVER_ERROR_BUSY;
+            }
+            atomic_fetch_add_explicit(&port->ring.dropped, len - chunk, memory_order_relaxed);
+            break;
+        }
+        memcpy(dst, src, chunk);
+        trace_ring_commit(&port->ring, rec, chunk, chunk, 0);
+        trace_tx_pump(&port->tx);
+        queued = true;
+        src += chunk;
+        len -= chunk;
+    }
+    return ARM_DRIVER_OK;
+}
+
+void tracelib_port_set_prefix(tracelib_port_t *port, const char *prefix)
+{
+    port->prefix = prefix;
+    port->prefix_len = prefix ? strlen(prefix) : 0;
+}
+
+int tracelib_port_printf(tracelib_port_t *port, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    const int ret = tracelib_port_vprintf(port, format, args);
+    va_end(args);
+    return ret;
+}
+
+/*
+ * Same as trace_message of the trace UART: the line is formatted on the
+ * stack and queued with its exact length.
+ */
+int tracelib_port_vprintf(tracelib_port_t *port, const char *format, va_list args)
+{
+    char buffer[TRACELIB_PORT_LINE_LEN];
+    int len = 0;
+
+    if (port->prefix_len < sizeof(buffer)) {
+        len = port->prefix_len;
+    }
+    if (len) {
+        memcpy(buffer, port->prefix, len);
+    }
+#if defined(TRACELIB_LIBC_FORMAT)
+    int msg_len = vsnprintf(buffer + len, sizeof(buffer) - len, format, args);
+#else
+    int msg_len = tracelib_vsnprintf(buffer + len, sizeof(buffer) - len, format, args);
+#endif
+    if (msg_len < 0) {
+        msg_len = 0;
+    }
+    len += msg_len;
+    if (len >= (int)sizeof(buffer)) {
+        len = sizeof(buffer) - 1;
+    }
+    return tracelib_port_send(port, buffer, len);
+}
+
+int tracelib_port_send_ref(tracelib_port_t *port, const void *data, uint32_t len,
+                           tracelib_release_t release, void *ctx)
+{
+    uint32_t rec;
+    uint8_t *dst = trace_ring_reserve(&port->ring, sizeof(trace_tx_ref_t), &rec);
+    if (dst == NULL) {
+        return ARM_DRIVER_ERROR_BUSY;
+    }
+
+    trace_tx_ref_put(dst, data, len, release, ctx);
+    trace_ring_commit(&port->ring, rec, sizeof(trace_tx_ref_t), sizeof(trace_tx_ref_t), TRACE_REC_REF);
+    trace_tx_pump(&port->tx);
+    return ARM_DRIVER_OK;
+}
+
+void tracelib_port_flush(tracelib_port_t *port)
+{
+    while (atomic_load_explicit(&port->tx.busy, memory_order_acquire) || trace_ring_ready(&port->ring)) {
+        trace_tx_pump(&port->tx);
+        __WFE();
+    }
+}
+
+void tracelib_port_get_stats(tracelib_port_t *port, tracelib_stats_t *stats)
+{
+    *stats = (tracelib_stats_t){ 0 };
+    stats->buffer_size = port->ring.size;
+    stats->used = atomic_load_explicit(&port->ring.head, memory_order_relaxed) -
+                  atomic_load_explicit(&port->ring.tail, memory_order_relaxed);
+    stats->high_water = atomic_load_explicit(&port->ring.high_water, memory_order_relaxed);
+    stats->dropped_bytes = atomic_load_explicit(&port->ring.dropped, memory_order_relaxed);
+    stats->retries = atomic_load_explicit(&port->ring.retries, memory_order_relaxed);
+    stats->sent_bytes = atomic_load_explicit(&port->tx.sent, memory_order_relaxed);
+}
@@ -0,0 +1,121 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+/*
+ * Additional tracelib output ports. The tracef/send_str API drives the trace
+ * UART of the core, a port drives another UART with its own transmit ring,
+ * driver and callback, for example to stream bulk data (tensors, audio) next
+ * to the human readable log. Every port keeps all of its state in its
+ * tracelib_port_t, so ports on different UARTs run side by side and next to
+ * the trace UART. Ports take raw data or printf style lines with their own
+ * prefix, there is no receive buffer.
+ *
+ * The CMSIS USART callback has no context argument, so every port takes one
+ * of TRACELIB_MAX_PORTS event trampolines while it is open.
+ */
+
+#ifndef TRACE_PORT_H_
+#define TRACE_PORT_H_
+
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include "Driver_USART.h"
+#include "trace_ring.h"
+#include "trace_tx.h"
+#include "uart_tracelib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef TRACELIB_MAX_PORTS
+#define TRACELIB_MAX_PORTS 2
+#endif
+
+/* Longest line of tracelib_port_printf, formatted on the caller's stack */
+#ifndef TRACELIB_PORT_LINE_LEN
+#define TRACELIB_PORT_LINE_LEN 256
+#endif
+
+typedef struct {
+    trace_tx_t tx;                          /* transmit engine, shared with the trace UART */
+    trace_ring_t ring;
+    ARM_USART_SignalEvent_t user_cb;
+    const char *prefix;                     /* put in front of every tracelib_port_printf line */
+    uint16_t prefix_len;
+    uint32_t index;                         /* event trampoline in use */
+} tracelib_port_t;
+
+/**
+ * @brief Open an output port on a UART.
+ *
+ * @param port     port state, must stay valid until tracelib_port_uninit
+ * @param drv      USART driver of the port, not the trace UART
+ * @param buf      transmit ring buffer, 4-byte aligned
+ * @param size     size of buf, power of two
+ * @param baudrate baud rate of the port
+ * @param cb       called with every USART event of the port, may be NULL
+ * @return ARM_DRIVER_ERROR_PARAMETER if size is not a power of two,
+ *         ARM_DRIVER_ERROR_BUSY if all TRACELIB_MAX_PORTS ports are open
+ */
+int tracelib_port_init(tracelib_port_t *port, ARM_DRIVER_USART *drv, uint8_t *buf, uint32_t size,
+                       uint32_t baudrate, ARM_USART_SignalEvent_t cb);
+
+/**
+ * @brief Wait for the queued output and close the port.
+ */
+int tracelib_port_uninit(tracelib_port_t *port);
+
+/**
+ * @brief Copy data into the transmit ring of the port and send it in the background.
+ *
+ * @return ARM_DRIVER_ERROR_BUSY if nothing could be queued
+ */
+int tracelib_port_send(tracelib_port_t *port, const void *data, uint32_t len);
+
+/**
+ * @brief Set the prefix of the tracelib_port_printf lines, NULL for none.
+ *
+ * The string is not copied and must stay valid while the port is open.
+ */
+void tracelib_port_set_prefix(tracelib_port_t *port, const char *prefix);
+
+/**
+ * @brief Format a line like tracef and queue it to the port.
+ *
+ * Lines are cut at TRACELIB_PORT_LINE_LEN - 1 characters, prefix included.
+ *
+ * @return ARM_DRIVER_ERROR_BUSY if the ring has no room for the line
+ */
+int tracelib_port_printf(tracelib_port_t *port, const char *format, ...);
+int tracelib_port_vprintf(tracelib_port_t *port, const char *format, va_list args);
+
+/**
+ * @brief Send data from the caller's buffer, see tracelib_send_ref.
+ */
+int tracelib_port_send_ref(tracelib_port_t *port, const void *data, uint32_t len,
+                           tracelib_release_t release, void *ctx);
+
+/**
+ * @brief Wait until the output queued to the port has been sent.
+ */
+void tracelib_port_flush(tracelib_port_t *port);
+
+/**
+ * @brief Get transmit statistics of the port, only the buffer fields are filled.
+ */
+void tracelib_port_get_stats(tracelib_port_t *port, tracelib_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TRACE_PORT_H_ */
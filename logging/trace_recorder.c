@@ -0,0 +1,258 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <string.h>
+
+#include "uart_tracelib.h"
+#include "trace_recorder.h"
+
+#if TRACELIB_RECORDER_SIZE > 0
+
+#define RECORDER_MAGIC  0x44524352 /* "RCRD" */
+#define RECORDER_MASK   (TRACELIB_RECORDER_SIZE - 1)
+
+typedef struct {
+    volatile uint32_t head;     /* bytes written completely, wraps at 2^32 */
+    volatile uint32_t crc;      /* CRC-32 of magic, size and head */
+} recorder_commit_t;
+
+/*
+ * Writers claim their bytes on reserved and copy them in, the last one to
+ * finish commits the head. The commits alternate between two slots, a reset
+ * in the middle of a commit leaves the other slot with the previous head.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t size;
+    _Atomic uint32_t reserved;  /* total bytes claimed, wraps at 2^32 */
+    recorder_commit_t commit[2];
+    uint8_t data[TRACELIB_RECORDER_SIZE];
+} trace_recorder_t;
+
+static trace_recorder_t recorder __attribute__((section(TRACELIB_RECORDER_SECTION))) __attribute__((aligned(4)));
+
+static atomic_bool recording;
+static _Atomic uint32_t writers;    // writes in progress
+static _Atomic uint32_t commits;    // picks the slot of the next commit
+static uint32_t recovered_end;      // head at boot
+static uint32_t recovered_len;      // bytes from before the reset
+
+static uint32_t crc32_update(uint32_t crc, uint32_t word)
+{
+    // nibble table keeps this cheap enough to run on every write
+    static const uint32_t table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+
+    crc ^= word;
+    for (int i = 0; i < 8; i++) {
+        crc = (crc >> 4) ^ table[crc & 0xF];
+    }
+    return crc;
+}
+
+static uint32_t header_crc(uint32_t head)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    crc = crc32_update(crc, recorder.magic);
+    crc = crc32_update(crc, recorder.size);
+    crc = crc32_update(crc, head);
+    return ~crc;
+}
+
+static void commit_store(uint32_t head)
+{
+    recorder_commit_t *slot = &recorder.commit[atomic_fetch_add_explicit(&commits, 1, memory_order_relaxed) & 1];
+
+    // the data of the head before the head, the head before its CRC
+    atomic_thread_fence(memory_order_release);
+    slot->head = head;
+    atomic_thread_fence(memory_order_release);
+    slot->crc = header_crc(head);
+}
+
+/*
+ * @return true if a commit slot is intact, the newest one is returned in head
+ */
+static bool commit_load(uint32_t *head)
+{
+    bool valid = false;
+
+    for (uint32_t i = 0; i < 2; i++) {
+        const uint32_t value = recorder.commit[i].head;
+        if (recorder.commit[i].crc == header_crc(value) && (!valid || (int32_t)(value - *head) > 0)) {
+            *head = value;
+            valid = true;
+        }
+    }
+    return valid;
+}
+
+void trace_recorder_init(void)
+{
+    uint32_t head = 0;
+
+    if (recorder.magic == RECORDER_MAGIC && recorder.size == TRACELIB_RECORDER_SIZE && commit_load(&head)) {
+        // bytes claimed after the last commit may have overwritten the oldest committed ones
+        const uint32_t torn = atomic_load_explicit(&recorder.reserved, memory_order_relaxed) - head;
+        const uint32_t room = torn < TRACELIB_RECORDER_SIZE ? TRACELIB_RECORDER_SIZE - torn : 0;
+
+        // keep appending after the head, the recovered output is lost as it gets overwritten
+        recovered_end = head;
+        recovered_len = head < room ? head : room;
+    } else {
+        recorder.magic = RECORDER_MAGIC;
+        recorder.size = TRACELIB_RECORDER_SIZE;
+        recovered_end = 0;
+        recovered_len = 0;
+    }
+    atomic_store_explicit(&recorder.reserved, head, memory_order_relaxed);
+    commit_store(head);
+    commit_store(head);
+    atomic_store_explicit(&recording, true, memory_order_release);
+}
+
+void trace_recorder_write(const void *data, uint32_t len)
+{
+    if (len == 0 || !atomic_load_explicit(&recording, memory_order_acquire)) {
+        return;
+    }
+
+    const uint8_t *src = data;
+    atomic_fetch_add_explicit(&writers, 1, memory_order_acquire);
+    uint32_t pos = atomic_fetch_add_explicit(&recorder.reserved, len, memory_order_relaxed);
+
+    // only the newest output fits if the record is larger than the buffer
+    if (len > TRACELIB_RECORDER_SIZE) {
+        pos += len - TRACELIB_RECORDER_SIZE;
+        src += len - TRACELIB_RECORDER_SIZE;
+        len = TRACELIB_RECORDER_SIZE;
+    }
+
+    const uint32_t offset = pos & RECORDER_MASK;
+    const uint32_t first = (len < TRACELIB_RECORDER_SIZE - offset) ? len : TRACELIB_RECORDER_SIZE - offset;
+    memcpy(&recorder.data[offset], src, first);
+    memcpy(recorder.data, src + first, len - first);
+
+    /*
+     * The last writer to finish commits all claimed bytes. A write from an
+     * ISR in between is committed by the ISR and once more by the loop.
+     */
+    if (atomic_fetch_sub_explicit(&writers, 1, memory_order_acq_rel) == 1) {
+        uint32_t head;
+        do {
+            head = atomic_load_explicit(&recorder.reserved, memory_order_relaxed);
+            commit_store(head);
+        } while (head != atomic_load_explicit(&recorder.reserved, memory_order_relaxed));
+    }
+}
+
+uint32_t tracelib_recorder_recovered(void)
+{
+    // output written since boot overwrites the oldest recovered bytes
+    const uint32_t written = atomic_load_explicit(&recorder.reserved, memory_order_relaxed) - recovered_end;
+    const uint32_t room = TRACELIB_RECORDER_SIZE - recovered_len;
+    if (written <= room) {
+        return recovered_len;
+    }
+    return written - room < recovered_len ? recovered_len - (written - room) : 0;
+}
+
+uint32_t tracelib_recorder_read(uint32_t offset, void *buf, uint32_t len)
+{
+    const uint32_t available = tracelib_recorder_recovered();
+    uint8_t *dst = buf;
+
+    if (offset >= available) {
+        return 0;
+    }
+    if (len > available - offset) {
+        len = available - offset;
+    }
+
+    const uint32_t start = recovered_end - available + offset;
+    for (uint32_t i = 0; i < len; i++) {
+        dst[i] = recorder.data[(start + i) & RECORDER_MASK];
+    }
+    return len;
+}
+
+int tracelib_recorder_dump(void)
+{
+    static const char banner[] = "\n--- recovered trace ---\n";
+    static const char footer[] = "\n--- end of recovered trace ---\n";
+    char chunk[64];
+    uint32_t offset = 0;
+    uint32_t len;
+
+    if (tracelib_recorder_recovered() == 0) {
+        return 0;
+    }
+
+    // the dump itself is not recorded, it would overwrite what is being dumped
+    atomic_store_explicit(&recording, false, memory_order_release);
+    send_str(banner, sizeof(banner) - 1);
+    while ((len = tracelib_recorder_read(offset, chunk, sizeof(chunk))) != 0) {
+        while (send_str(chunk, len) == ARM_DRIVER_ERROR_BUSY) {
+            tracelib_flush();
+        }
+        offset += len;
+    }
+    send_str(footer, sizeof(footer) - 1);
+    tracelib_flush();
+
+    tracelib_recorder_clear();
+    return offset;
+}
+
+void tracelib_recorder_clear(void)
+{
+    recovered_len = 0;
+    atomic_store_explicit(&recording, true, memory_order_release);
+}
+
+#else
+
+void trace_recorder_init(void)
+{
+}
+
+void trace_recorder_write(const void *data, uint32_t len)
+{
+    (void)data;
+    (void)len;
+}
+
+uint32_t tracelib_recorder_recovered(void)
+{
+    return 0;
+}
+
+uint32_t tracelib_recorder_read(uint32_t offset, void *buf, uint32_t len)
+{
+    (void)offset;
+    (void)buf;
+    (void)len;
+    return 0;
+}
+
+int tracelib_recorder_dump(void)
+{
+    return 0;
+}
+
+void tracelib_recorder_clear(void)
+{
+}
+
+#endif // TRACELIB_RECORDER_SIZE
@@ -0,0 +1,62 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+/*
+ * Flight recorder of tracelib. A copy of all output is kept in a circular
+ * buffer in a RAM section that is not initialized at boot, so the output
+ * from before a warm reset can be read after it. Enabled by defining
+ * TRACELIB_RECORDER_SIZE (power of two).
+ *
+ * The header holds a magic value, the buffer size and the position up to
+ * which all writes have completed, protected with a CRC-32. The position is
+ * committed after the data is copied, alternating between two slots, so a
+ * reset in the middle of a write or a commit recovers the output up to the
+ * last completed write. The contents themselves are not covered by the CRC.
+ *
+ * The section must not be in write-back cached memory (use TCM or an MPU
+ * region without write-back) or the newest output is lost with the cache.
+ */
+
+#ifndef TRACE_RECORDER_H_
+#define TRACE_RECORDER_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef TRACELIB_RECORDER_SIZE
+#define TRACELIB_RECORDER_SIZE 0
+#endif
+
+#ifndef TRACELIB_RECORDER_SECTION
+#define TRACELIB_RECORDER_SECTION ".noinit"
+#endif
+
+#if (TRACELIB_RECORDER_SIZE & (TRACELIB_RECORDER_SIZE - 1)) != 0
+#error "TRACELIB_RECORDER_SIZE must be a power of two"
+#endif
+
+/**
+ * @brief Validate the contents left from before the reset and start recording.
+ */
+void trace_recorder_init(void);
+
+/**
+ * @brief Append output to the recorder. Safe from any context.
+ */
+void trace_recorder_write(const void *data, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TRACE_RECORDER_H_ */
@@ -0,0 +1,157 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+#include <string.h>
+
+#include "trace_ring.h"
+
+static inline _Atomic uint32_t *ring_hdr(trace_ring_t *ring, uint32_t index)
+{
+    return (_Atomic uint32_t *)&ring->buf[index & (ring->size - 1)];
+}
+
+void trace_ring_init(trace_ring_t *ring, uint8_t *buf, uint32_t size)
+{
+    ring->buf = buf;
+    ring->size = size;
+    atomic_store_explicit(&ring->head, 0, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, 0, memory_order_relaxed);
+    atomic_store_explicit(&ring->dropped, 0, memory_order_relaxed);
+    atomic_store_explicit(&ring->high_water, 0, memory_order_relaxed);
+    atomic_store_explicit(&ring->retries, 0, memory_order_relaxed);
+}
+
+uint8_t *trace_ring_reserve(trace_ring_t *ring, uint32_t len, uint32_t *rec)
+{
+    const uint32_t need = TRACE_RING_HDR_SIZE + TRACE_RING_ALIGN(len);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t pad;
+    uint32_t used;
+
+    // the length field of the header is 16 bits
+    if (len > TRACE_REC_MAX_LEN) {
+        atomic_fetch_add_explicit(&ring->dropped, len, memory_order_relaxed);
+        return NULL;
+    }
+
+    for (;;) {
+        const uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        const uint32_t offset = head & (ring->size - 1);
+
+        // records never wrap, the end of the buffer is skipped instead
+        pad = (offset + need > ring->size) ? ring->size - offset : 0;
+        used = head + pad + need - tail;
+
+        if (used > ring->size) {
+            // tail may have overtaken a stale head, retry with a fresh one
+            const uint32_t current = atomic_load_explicit(&ring->head, memory_order_relaxed);
+            if (current != head) {
+                head = current;
+                continue;
+            }
+            atomic_fetch_add_explicit(&ring->dropped, len, memory_order_relaxed);
+            return NULL;
+        }
+
+        if (atomic_compare_exchange_weak_explicit(&ring->head, &head, head + pad + need,
+                                                  memory_order_acquire, memory_order_relaxed)) {
+            break;
+        }
+        atomic_fetch_add_explicit(&ring->retries, 1, memory_order_relaxed);
+    }
+
+    uint32_t peak = atomic_load_explicit(&ring->high_water, memory_order_relaxed);
+    while (used > peak &&
+           !atomic_compare_exchange_weak_explicit(&ring->high_water, &peak, used,
+                                                  memory_order_relaxed, memory_order_relaxed));
+
+    if (pad) {
+        atomic_store_explicit(ring_hdr(ring, head), pad | TRACE_REC_SKIP | TRACE_REC_COMMITTED,
+                              memory_order_release);
+        head += pad;
+    }
+    *rec = head;
+    return &ring->buf[(head & (ring->size - 1)) + TRACE_RING_HDR_SIZE];
+}
+
+bool trace_ring_fits(trace_ring_t *ring, uint32_t len)
+{
+    const uint32_t need = TRACE_RING_HDR_SIZE + TRACE_RING_ALIGN(len);
+    const uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    const uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    const uint32_t offset = head & (ring->size - 1);
+    const uint32_t pad = (offset + need > ring->size) ? ring->size - offset : 0;
+
+    return len <= TRACE_REC_MAX_LEN && head + pad + need - tail <= ring->size;
+}
+
+void trace_ring_commit(trace_ring_t *ring, uint32_t rec, uint32_t reserved, uint32_t len, uint32_t flags)
+{
+    if (len == 0) {
+        // abandoned reservation, skip it as a whole
+        atomic_store_explicit(ring_hdr(ring, rec),
+                              (TRACE_RING_HDR_SIZE + TRACE_RING_ALIGN(reserved)) | TRACE_REC_SKIP | TRACE_REC_COMMITTED,
+                              memory_order_release);
+        return;
+    }
+
+    const uint32_t unused = TRACE_RING_ALIGN(reserved) - TRACE_RING_ALIGN(len);
+    if (unused) {
+        atomic_store_explicit(ring_hdr(ring, rec + TRACE_RING_HDR_SIZE + TRACE_RING_ALIGN(len)),
+                              unused | TRACE_REC_SKIP | TRACE_REC_COMMITTED, memory_order_relaxed);
+    }
+    atomic_store_explicit(ring_hdr(ring, rec), len | flags | TRACE_REC_COMMITTED, memory_order_release);
+}
+
+static inline uint32_t record_size(uint32_t hdr)
+{
+    const uint32_t len = hdr & TRACE_REC_LEN_Msk;
+    return (hdr & TRACE_REC_SKIP) ? len : TRACE_RING_HDR_SIZE + TRACE_RING_ALIGN(len);
+}
+
+void trace_ring_release(trace_ring_t *ring, uint32_t hdr)
+{
+    const uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    const uint32_t size = record_size(hdr);
+
+    memset(&ring->buf[tail & (ring->size - 1)], 0, size);
+    atomic_store_explicit(&ring->tail, tail + size, memory_order_release);
+}
+
+uint8_t *trace_ring_peek(trace_ring_t *ring, uint32_t *hdr)
+{
+    for (;;) {
+        const uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        if (tail == atomic_load_explicit(&ring->head, memory_order_relaxed)) {
+            return NULL;
+        }
+
+        const uint32_t value = atomic_load_explicit(ring_hdr(ring, tail), memory_order_acquire);
+        if ((value & TRACE_REC_COMMITTED) == 0) {
+            // producer still writing
+            return NULL;
+        }
+
+        if ((value & TRACE_REC_SKIP) == 0) {
+            *hdr = value;
+            return &ring->buf[(tail & (ring->size - 1)) + TRACE_RING_HDR_SIZE];
+        }
+        trace_ring_release(ring, value);
+    }
+}
+
+bool trace_ring_ready(trace_ring_t *ring)
+{
+    const uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    if (tail == atomic_load_explicit(&ring->head, memory_order_relaxed)) {
+        return false;
+    }
+    return (atomic_load_explicit(ring_hdr(ring, tail), memory_order_acquire) & TRACE_REC_COMMITTED) != 0;
+}
@@ -0,0 +1,156 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+/*
+ * Lock-free multi-producer, single-consumer record ring used by tracelib.
+ *
+ * Producers reserve a contiguous record with a CAS on the head index, fill it
+ * and commit it by setting a flag in the record header, so threads and ISRs
+ * never wait for each other. The single consumer reads committed records in
+ * order and releases them. Records never wrap, the end of the buffer is
+ * covered by a skip record instead.
+ *
+ * Every record starts with a 32-bit header word:
+ * bits 0..15 payload length (or total length for skip records),
+ * bit 29 set for descriptor records, bit 30 set for skip records and
+ * bit 31 set once the producer has finished writing the payload.
+ * Released records are zeroed so a zero header always means "not ready".
+ *
+ * When TRACE_RING_HDR_SIZE is 8 the second header word is free for the user
+ * (tracelib stores a timestamp there for the shared multi-core channel).
+ */
+
+#ifndef TRACE_RING_H_
+#define TRACE_RING_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TRACE_REC_LEN_Msk      0xFFFFUL
+#define TRACE_REC_REF          (1UL << 29)
+#define TRACE_REC_SKIP         (1UL << 30)
+#define TRACE_REC_COMMITTED    (1UL << 31)
+
+#if defined(TRACELIB_CHANNEL_ADDR)
+#define TRACE_RING_HDR_SIZE    8U
+#else
+#define TRACE_RING_HDR_SIZE    4U
+#endif
+
+#define TRACE_RING_ALIGN(x)    (((x) + 3U) & ~3U)
+
+/*
+ * Longest payload of a record. Its header, the padding skipped in front of
+ * it and the skip record of an abandoned reservation all have to fit in the
+ * length field, whatever the size of the ring.
+ */
+#define TRACE_REC_MAX_LEN      ((TRACE_REC_LEN_Msk - TRACE_RING_HDR_SIZE) & ~3UL)
+
+typedef struct {
+    _Atomic uint32_t head;          /* next free byte, advanced by producers */
+    _Atomic uint32_t tail;          /* oldest unconsumed byte, advanced by the consumer */
+    _Atomic uint32_t dropped;       /* payload bytes that did not fit */
+    _Atomic uint32_t high_water;    /* peak number of bytes in use */
+    _Atomic uint32_t retries;       /* reservations retried because another producer won the race */
+    uint32_t size;                  /* buffer size in bytes, power of two */
+    uint8_t *buf;
+} trace_ring_t;
+
+/**
+ * @brief Initialize an empty ring on a zeroed, 4-byte aligned buffer.
+ *
+ * @param size buffer size in bytes, must be a power of two
+ */
+void trace_ring_init(trace_ring_t *ring, uint8_t *buf, uint32_t size);
+
+/**
+ * @brief Reserve a record of len payload bytes. Safe from any context.
+ *
+ * @param rec position of the record, pass to trace_ring_commit
+ * @return pointer to the payload or NULL if the ring is full or len is larger
+ *         than TRACE_REC_MAX_LEN
+ */
+uint8_t *trace_ring_reserve(trace_ring_t *ring, uint32_t len, uint32_t *rec);
+
+/**
+ * @brief Get the payload of a reserved record from its position.
+ */
+static inline uint8_t *trace_ring_payload(trace_ring_t *ring, uint32_t rec)
+{
+    return &ring->buf[(rec & (ring->size - 1)) + TRACE_RING_HDR_SIZE];
+}
+
+/**
+ * @brief Publish a reserved record.
+ *
+ * len may be smaller than the reserved length, the rest of the reservation is
+ * skipped. A zero len abandons the reservation.
+ *
+ * @param flags extra header flags, TRACE_REC_REF or 0
+ */
+void trace_ring_commit(trace_ring_t *ring, uint32_t rec, uint32_t reserved, uint32_t len, uint32_t flags);
+
+/**
+ * @brief Get the oldest committed record. Consumer only.
+ *
+ * Skip records at the head of the ring are released on the way.
+ *
+ * @param hdr header word of the record
+ * @return pointer to the payload or NULL if no committed record is available
+ */
+uint8_t *trace_ring_peek(trace_ring_t *ring, uint32_t *hdr);
+
+/**
+ * @brief Release the record returned by trace_ring_peek. Consumer only.
+ */
+void trace_ring_release(trace_ring_t *ring, uint32_t hdr);
+
+/**
+ * @brief Check if the oldest record is committed.
+ */
+bool trace_ring_ready(trace_ring_t *ring);
+
+/**
+ * @brief Check if a record of len bytes fits into the ring right now.
+ *
+ * Only a hint for producers that wait for room, another producer may take
+ * the room before trace_ring_reserve.
+ */
+bool trace_ring_fits(trace_ring_t *ring, uint32_t len);
+
+/**
+ * @brief Check if the ring holds no records at all.
+ */
+static inline bool trace_ring_empty(trace_ring_t *ring)
+{
+    return atomic_load_explicit(&ring->tail, memory_order_relaxed) ==
+           atomic_load_explicit(&ring->head, memory_order_relaxed);
+}
+
+#if TRACE_RING_HDR_SIZE == 8
+/**
+ * @brief Get the second header word of a record from its payload pointer.
+ */
+static inline uint32_t *trace_ring_meta(uint8_t *payload)
+{
+    return (uint32_t *)(payload - 4);
+}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TRACE_RING_H_ */
@@ -0,0 +1,256 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+/*
+ * Control shell on the trace UART. Complete lines are taken from the receive
+ * buffer by tracelib_shell_poll and executed in the caller's context, the
+ * answers are traced with tracef_unlimited, the rate limit does not apply.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "uart_tracelib.h"
+
+#ifndef TRACELIB_SHELL_LINE_LEN
+#define TRACELIB_SHELL_LINE_LEN 64
+#endif
+
+#ifndef TRACELIB_SHELL_MAX_COMMANDS
+#define TRACELIB_SHELL_MAX_COMMANDS 8
+#endif
+
+#define SHELL_MAX_ARGS 6
+
+typedef struct {
+    const char *name;
+    const char *help;
+    tracelib_shell_handler_t handler;
+} shell_command_t;
+
+static void cmd_help(int argc, char *argv[]);
+static void cmd_level(int argc, char *argv[]);
+static void cmd_stats(int argc, char *argv[]);
+static void cmd_reset(int argc, char *argv[]);
+static void cmd_rate(int argc, char *argv[]);
+static void cmd_sinks(int argc, char *argv[]);
+static void cmd_dump(int argc, char *argv[]);
+
+static const shell_command_t builtin_commands[] = {
+    { "help",  "list commands", cmd_help },
+    { "level", "[module|all [level]] show or set trace levels (0 none .. 5 verbose)", cmd_level },
+    { "stats", "show tracelib counters", cmd_stats },
+    { "reset", "reset tracelib counters", cmd_reset },
+    { "rate",  "<burst> [window_ms] limit tracef rate, 0 disables", cmd_rate },
+    { "sinks", "[mask] show or select output sinks", cmd_sinks },
+    { "dump",  "send the output recovered from before the last reset", cmd_dump },
+};
+
+static shell_command_t user_commands[TRACELIB_SHELL_MAX_COMMANDS];
+static uint32_t user_command_count;
+
+static bool parse_number(const char *str, uint32_t *value)
+{
+    char *end;
+    *value = strtoul(str, &end, 0);
+    return end != str && *end == '\0';
+}
+
+static void cmd_help(int argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+    for (uint32_t i = 0; i < sizeof(builtin_commands) / sizeof(builtin_commands[0]); i++) {
+        tracef_unlimited("%s %s\n", builtin_commands[i].name, builtin_commands[i].help);
+    }
+    for (uint32_t i = 0; i < user_command_count; i++) {
+        tracef_unlimited("%s %s\n", user_commands[i].name, user_commands[i].help);
+    }
+}
+
+static void cmd_level(int argc, char *argv[])
+{
+    uint32_t module = TRACELIB_MAX_MODULES;
+    uint32_t level;
+
+    if (argc > 1 && strcmp(argv[1], "all") != 0 &&
+        (!parse_number(argv[1], &module) || module >= TRACELIB_MAX_MODULES)) {
+        tracef_unlimited("invalid module %s\n", argv[1]);
+        return;
+    }
+
+    if (argc > 2) {
+        if (!parse_number(argv[2], &level) || level > TRACE_LEVEL_VERBOSE) {
+            tracef_unlimited("invalid level %s\n", argv[2]);
+            return;
+        }
+        tracelib_set_level(module, level);
+    }
+
+    if (module < TRACELIB_MAX_MODULES) {
+        tracef_unlimited("module %lu level %lu\n", (unsigned long)module, (unsigned long)tracelib_get_level(module));
+        return;
+    }
+    for (module = 0; module < TRACELIB_MAX_MODULES; module += 8) {
+        tracef_unlimited("modules %2lu..%2lu: %lu %lu %lu %lu %lu %lu %lu %lu\n",
+                         (unsigned long)module, (unsigned long)module + 7,
+                         (unsigned long)tracelib_get_level(module + 0), (unsigned long)tracelib_get_level(module + 1),
+                         (unsigned long)tracelib_get_level(module + 2), (unsigned long)tracelib_get_level(module + 3),
+                         (unsigned long)tracelib_get_level(module + 4), (unsigned long)tracelib_get_level(module + 5),
+                         (unsigned long)tracelib_get_level(module + 6), (unsigned long)tracelib_get_level(module + 7));
+    }
+}
+
+static void cmd_stats(int argc, char *argv[])
+{
+    tracelib_stats_t stats;
+    uint32_t rx_available;
+    uint32_t rx_overflow;
+
+    (void)argc;
+    (void)argv;
+    tracelib_get_stats(&stats);
+    tracelib_get_rx_stats(&rx_available, &rx_overflow);
+    tracef_unlimited("tx: size %lu used %lu peak %lu sent %lu dropped %lu retries %lu\n",
+                     (unsigned long)stats.buffer_size, (unsigned long)stats.used, (unsigned long)stats.high_water,
+                     (unsigned long)stats.sent_bytes, (unsigned long)stats.dropped_bytes, (unsigned long)stats.retries);
+    tracef_unlimited("calls: thread %lu isr %lu nested %lu suppressed %lu\n",
+                     (unsigned long)stats.context_calls[TRACELIB_CONTEXT_THREAD],
+                     (unsigned long)stats.context_calls[TRACELIB_CONTEXT_ISR],
+                     (unsigned long)stats.context_calls[TRACELIB_CONTEXT_NESTED],
+                     (unsigned long)stats.suppressed);
+    tracef_unlimited("rx: buffered %lu overflow %lu\n", (unsigned long)rx_available, (unsigned long)rx_overflow);
+    if (stats.uart_elapsed_cycles) {
+        tracef_unlimited("uart: power ups %lu duty %lu.%lu%%\n", (unsigned long)stats.uart_power_ups,
+                         (unsigned long)(stats.uart_on_cycles * 100 / stats.uart_elapsed_cycles),
+                         (unsigned long)(stats.uart_on_cycles * 1000 / stats.uart_elapsed_cycles % 10));
+    }
+    if (stats.tracef_latency.calls) {
+        tracef_unlimited("tracef: calls %lu avg %lu max %lu cycles\n",
+                         (unsigned long)stats.tracef_latency.calls,
+                         (unsigned long)(stats.tracef_latency.total_cycles / stats.tracef_latency.calls),
+                         (unsigned long)stats.tracef_latency.max_cycles);
+    }
+}
+
+static void cmd_reset(int argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+    tracelib_reset_stats();
+}
+
+static void cmd_rate(int argc, char *argv[])
+{
+    uint32_t burst;
+    uint32_t window_ms = 1000;
+
+    if (argc < 2 || !parse_number(argv[1], &burst) || (argc > 2 && !parse_number(argv[2], &window_ms))) {
+        tracef_unlimited("usage: rate <burst> [window_ms]\n");
+        return;
+    }
+    tracelib_set_rate_limit(burst, window_ms);
+}
+
+static void cmd_sinks(int argc, char *argv[])
+{
+    uint32_t sinks;
+
+    if (argc > 1) {
+        if (!parse_number(argv[1], &sinks)) {
+            tracef_unlimited("invalid mask %s\n", argv[1]);
+            return;
+        }
+        tracelib_set_sinks(sinks);
+    }
+    tracef_unlimited("sinks 0x%lx\n", (unsigned long)tracelib_get_sinks());
+}
+
+static void cmd_dump(int argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+    if (tracelib_recorder_dump() == 0) {
+        tracef_unlimited("nothing recovered\n");
+    }
+}
+
+/* Split off the next word of the line in place, NULL at its end */
+static char *next_token(char **pos)
+{
+    char *start = *pos + strspn(*pos, " \t");
+
+    if (*start == '\0') {
+        *pos = start;
+        return NULL;
+    }
+    char *end = start + strcspn(start, " \t");
+    if (*end != '\0') {
+        *end++ = '\0';
+    }
+    *pos = end;
+    return start;
+}
+
+static const shell_command_t *find_command(const char *name)
+{
+    for (uint32_t i = 0; i < sizeof(builtin_commands) / sizeof(builtin_commands[0]); i++) {
+        if (strcmp(builtin_commands[i].name, name) == 0) {
+            return &builtin_commands[i];
+        }
+    }
+    for (uint32_t i = 0; i < user_command_count; i++) {
+        if (strcmp(user_commands[i].name, name) == 0) {
+            return &user_commands[i];
+        }
+    }
+    return NULL;
+}
+
+int tracelib_shell_register(const char *name, const char *help, tracelib_shell_handler_t handler)
+{
+    if (user_command_count >= TRACELIB_SHELL_MAX_COMMANDS) {
+        return ARM_DRIVER_ERROR;
+    }
+    user_commands[user_command_count++] = (shell_command_t){ name, help, handler };
+    return ARM_DRIVER_OK;
+}
+
+void tracelib_shell_execute(char *line)
+{
+    char *argv[SHELL_MAX_ARGS];
+    int argc = 0;
+    char *token;
+
+    while (argc < SHELL_MAX_ARGS && (token = next_token(&line)) != NULL) {
+        argv[argc++] = token;
+    }
+    if (argc == 0) {
+        return;
+    }
+
+    const shell_command_t *command = find_command(argv[0]);
+    if (command == NULL) {
+        tracef_unlimited("unknown command %s, try help\n", argv[0]);
+        return;
+    }
+    command->handler(argc, argv);
+}
+
+bool tracelib_shell_poll(void)
+{
+    char line[TRACELIB_SHELL_LINE_LEN];
+
+    if (tracelib_read_line(line, sizeof(line), 0) < 0) {
+        return false;
+    }
+    tracelib_shell_execute(line);
+    return true;
+}
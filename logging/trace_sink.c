@@ -0,0 +1,87 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+#include <string.h>
+#include <RTE_Components.h>
+#include CMSIS_device_header
+
+#include "uart_tracelib.h"
+#include "trace_sink.h"
+
+#ifndef TRACELIB_ITM_PORT
+#define TRACELIB_ITM_PORT 0
+#endif
+
+trace_ram_sink_t tracelib_ram_sink = { .magic = TRACELIB_RAM_SINK_MAGIC, .size = TRACELIB_RAM_SINK_SIZE };
+
+static tracelib_sink_write_t user_sink;
+
+static void ram_write(const uint8_t *data, uint32_t len)
+{
+    uint32_t head = tracelib_ram_sink.head;
+
+    // only the newest output fits if the record is larger than the buffer
+    if (len > TRACELIB_RAM_SINK_SIZE) {
+        head += len - TRACELIB_RAM_SINK_SIZE;
+        data += len - TRACELIB_RAM_SINK_SIZE;
+        len = TRACELIB_RAM_SINK_SIZE;
+    }
+
+    const uint32_t offset = head & (TRACELIB_RAM_SINK_SIZE - 1);
+    const uint32_t first = (len < TRACELIB_RAM_SINK_SIZE - offset) ? len : TRACELIB_RAM_SINK_SIZE - offset;
+    memcpy(&tracelib_ram_sink.data[offset], data, first);
+    memcpy(tracelib_ram_sink.data, data + first, len - first);
+    tracelib_ram_sink.head = head + len;
+}
+
+/*
+ * Write to an ITM stimulus port, whole words while possible. Nothing is
+ * written unless a debugger has enabled ITM and the port.
+ */
+static void itm_write(const uint8_t *data, uint32_t len)
+{
+#if defined(A32)
+    (void)data;
+    (void)len;
+#else
+    if ((ITM->TCR & ITM_TCR_ITMENA_Msk) == 0 || (ITM->TER & (1UL << TRACELIB_ITM_PORT)) == 0) {
+        return;
+    }
+
+    for (; len >= 4; data += 4, len -= 4) {
+        uint32_t word;
+        memcpy(&word, data, sizeof(word));
+        while (ITM->PORT[TRACELIB_ITM_PORT].u32 == 0U);
+        ITM->PORT[TRACELIB_ITM_PORT].u32 = word;
+    }
+    for (; len; data++, len--) {
+        while (ITM->PORT[TRACELIB_ITM_PORT].u32 == 0U);
+        ITM->PORT[TRACELIB_ITM_PORT].u8 = *data;
+    }
+#endif
+}
+
+void trace_sink_write(uint32_t sinks, const void *data, uint32_t len)
+{
+    if (sinks & TRACELIB_SINK_RAM) {
+        ram_write(data, len);
+    }
+    if (sinks & TRACELIB_SINK_ITM) {
+        itm_write(data, len);
+    }
+    if ((sinks & TRACELIB_SINK_USER) && user_sink) {
+        user_sink(data, len);
+    }
+}
+
+void tracelib_set_user_sink(tracelib_sink_write_t write)
+{
+    user_sink = write;
+}
@@ -0,0 +1,59 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+/*
+ * Output backends of tracelib other than the UART. The transmit ring is
+ * drained into every enabled sink (see TRACELIB_SINK_* in uart_tracelib.h),
+ * these are called with each record from the single consumer, in order.
+ * The UART is asynchronous and handled by uart_tracelib.c itself.
+ */
+
+#ifndef TRACE_SINK_H_
+#define TRACE_SINK_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef TRACELIB_RAM_SINK_SIZE
+#define TRACELIB_RAM_SINK_SIZE 4096
+#endif
+
+#if (TRACELIB_RAM_SINK_SIZE & (TRACELIB_RAM_SINK_SIZE - 1)) != 0
+#error "TRACELIB_RAM_SINK_SIZE must be a power of two"
+#endif
+
+#define TRACELIB_RAM_SINK_MAGIC 0x4B4E4953 /* "SINK" */
+
+/*
+ * Circular buffer for a debugger to read, the oldest output is overwritten.
+ * The last min(head, size) bytes ending at data[head % size] are valid.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t size;
+    volatile uint32_t head;     /* total bytes written, wraps at 2^32 */
+    uint8_t data[TRACELIB_RAM_SINK_SIZE];
+} trace_ram_sink_t;
+
+extern trace_ram_sink_t tracelib_ram_sink;
+
+/**
+ * @brief Write a record to the synchronous sinks selected in sinks.
+ */
+void trace_sink_write(uint32_t sinks, const void *data, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TRACE_SINK_H_ */
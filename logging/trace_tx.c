@@ -0,0 +1,142 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+#include <stddef.h>
+
+#include "alifs_profile.h"
+#include "trace_sink.h"
+#include "trace_tx.h"
+
+#if defined(TRACELIB_USART_INSTANCE)
+extern ARM_DRIVER_USART ARM_Driver_USART_(TRACELIB_USART_INSTANCE);
+#endif
+
+void trace_tx_init(trace_tx_t *tx, ARM_DRIVER_USART *drv, trace_ring_t *ring, const trace_tx_ops_t *ops,
+                   uint32_t sinks)
+{
+    tx->drv = drv;
+    tx->ring = ring;
+    tx->ops = ops;
+    tx->inflight_release = NULL;
+    atomic_store_explicit(&tx->sinks, sinks, memory_order_relaxed);
+    atomic_store_explicit(&tx->busy, false, memory_order_relaxed);
+    atomic_store_explicit(&tx->sent, 0, memory_order_relaxed);
+}
+
+trace_ring_t *trace_tx_next(trace_tx_t *tx, uint32_t *hdr, uint8_t **payload)
+{
+    if (tx->ops && tx->ops->next) {
+        return tx->ops->next(hdr, payload);
+    }
+    *payload = trace_ring_peek(tx->ring, hdr);
+    return *payload ? tx->ring : NULL;
+}
+
+bool trace_tx_ready(trace_tx_t *tx)
+{
+    if (tx->ops && tx->ops->ready) {
+        return tx->ops->ready();
+    }
+    return trace_ring_ready(tx->ring);
+}
+
+/*
+ * Hand a record to the driver of the engine. The trace UART bound at compile
+ * time (TRACELIB_USART_INSTANCE) is called through its access structure, the
+ * same as in uart_tracelib.c, the output ports through their driver pointer.
+ */
+static inline int32_t tx_send(trace_tx_t *tx, const void *data, uint32_t num)
+{
+#if defined(TRACELIB_USART_INSTANCE)
+    if (tx->drv == &ARM_Driver_USART_(TRACELIB_USART_INSTANCE)) {
+        return ARM_Driver_USART_(TRACELIB_USART_INSTANCE).Send(data, num);
+    }
+#endif
+    return tx->drv->Send(data, num);
+}
+
+/*
+ * Write the next committed records to the sinks and hand the first one to
+ * the USART driver. Records are released right away when the UART sink is
+ * not selected. Must be called with the busy token held.
+ *
+ * @return true if a transmission was started.
+ */
+static bool tx_start(trace_tx_t *tx)
+{
+    trace_ring_t *ring;
+    uint32_t hdr;
+    uint8_t *payload;
+
+    while ((ring = trace_tx_next(tx, &hdr, &payload)) != NULL) {
+        const uint32_t sinks = atomic_load_explicit(&tx->sinks, memory_order_relaxed);
+        trace_tx_ref_t ref = { .data = payload, .len = hdr & TRACE_REC_LEN_Msk };
+
+        if (hdr & TRACE_REC_REF) {
+            ref = trace_tx_ref_get(payload);
+        }
+
+        trace_sink_write(sinks, ref.data, ref.len);
+
+        if (sinks & TRACELIB_SINK_UART) {
+            tx->inflight_ring = ring;
+            tx->inflight_hdr = hdr;
+            tx->inflight_release = ref.release;
+            tx->inflight_ctx = ref.ctx;
+            tx->inflight_len = ref.len;
+            if (tx_send(tx, ref.data, ref.len) == ARM_DRIVER_OK) {
+                return true;
+            }
+            atomic_fetch_add_explicit(&ring->dropped, ref.len, memory_order_relaxed);
+            tx->inflight_release = NULL;
+        } else {
+            atomic_fetch_add_explicit(&tx->sent, ref.len, memory_order_relaxed);
+        }
+        if (ref.release) {
+            ref.release(ref.ctx);
+        }
+        trace_ring_release(ring, hdr);
+    }
+    return false;
+}
+
+void trace_tx_pump(trace_tx_t *tx)
+{
+    while (!atomic_exchange_explicit(&tx->busy, true, memory_order_acquire)) {
+        if (tx->ops && tx->ops->power_up && !tx->ops->power_up()) {
+            atomic_store_explicit(&tx->busy, false, memory_order_release);
+            return;
+        }
+        if (tx_start(tx)) {
+            return;
+        }
+        atomic_store_explicit(&tx->busy, false, memory_order_release);
+
+        // a record may have been committed after tx_start looked at it
+        if (!trace_tx_ready(tx)) {
+            tx->idle_since = alifs_profile_end(0);
+            return;
+        }
+    }
+}
+
+void trace_tx_complete(trace_tx_t *tx)
+{
+    if (tx->inflight_release) {
+        tx->inflight_release(tx->inflight_ctx);
+        tx->inflight_release = NULL;
+    }
+
+    trace_ring_release(tx->inflight_ring, tx->inflight_hdr);
+    atomic_fetch_add_explicit(&tx->sent, tx->inflight_len, memory_order_relaxed);
+
+    atomic_store_explicit(&tx->busy, false, memory_order_release);
+    trace_tx_pump(tx);
+}
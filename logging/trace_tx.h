@@ -0,0 +1,120 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+/*
+ * Transmit engine of tracelib, shared by the trace UART (uart_tracelib.c)
+ * and the output ports (trace_port.c). Internal to the library.
+ *
+ * Producers commit records into a trace_ring and call trace_tx_pump. The
+ * engine hands one record at a time to the USART driver and the send
+ * complete event (trace_tx_complete) releases it and starts the next. The
+ * busy token is taken with an exchange and the ring is checked again after
+ * releasing it, so threads, ISRs and the event can all start a transmission
+ * without locks.
+ */
+
+#ifndef TRACE_TX_H_
+#define TRACE_TX_H_
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "Driver_USART.h"
+#include "trace_ring.h"
+#include "uart_tracelib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Payload of a TRACE_REC_REF record, the data is sent from the caller's
+ * buffer. Records are only 4-byte aligned, so the descriptor is copied in
+ * and out of the ring (8-byte pointers of 64-bit hosts).
+ */
+typedef struct {
+    const void *data;
+    uint32_t len;
+    tracelib_release_t release;
+    void *ctx;
+} trace_tx_ref_t;
+
+static inline void trace_tx_ref_put(uint8_t *payload, const void *data, uint32_t len,
+                                    tracelib_release_t release, void *ctx)
+{
+    const trace_tx_ref_t ref = { .data = data, .len = len, .release = release, .ctx = ctx };
+    memcpy(payload, &ref, sizeof(ref));
+}
+
+static inline trace_tx_ref_t trace_tx_ref_get(const uint8_t *payload)
+{
+    trace_tx_ref_t ref;
+    memcpy(&ref, payload, sizeof(ref));
+    return ref;
+}
+
+/*
+ * Optional hooks of an engine, any of them may be NULL. The trace UART uses
+ * them to merge the rings of the multi-core channel and to power the UART up
+ * for batched output.
+ */
+typedef struct {
+    trace_ring_t *(*next)(uint32_t *hdr, uint8_t **payload);   /* oldest record of several rings */
+    bool (*ready)(void);                                        /* any record of several rings */
+    bool (*power_up)(void);                                     /* called with the busy token held */
+} trace_tx_ops_t;
+
+typedef struct {
+    ARM_DRIVER_USART *drv;
+    trace_ring_t *ring;
+    const trace_tx_ops_t *ops;
+    _Atomic uint32_t sinks;                 /* TRACELIB_SINK_* the records go to */
+    atomic_bool busy;                       /* a record is handed to the driver */
+    trace_ring_t *inflight_ring;            /* ring of the record being transmitted */
+    uint32_t inflight_hdr;
+    uint32_t inflight_len;                  /* bytes handed to the driver */
+    tracelib_release_t inflight_release;    /* of a TRACE_REC_REF record, NULL otherwise */
+    void *inflight_ctx;
+    _Atomic uint32_t sent;
+    uint32_t idle_since;                    /* cycle count at the end of the last burst */
+} trace_tx_t;
+
+void trace_tx_init(trace_tx_t *tx, ARM_DRIVER_USART *drv, trace_ring_t *ring, const trace_tx_ops_t *ops,
+                   uint32_t sinks);
+
+/**
+ * @brief Peek the next committed record, see trace_ring_peek.
+ *
+ * @return ring of the record or NULL if there is none
+ */
+trace_ring_t *trace_tx_next(trace_tx_t *tx, uint32_t *hdr, uint8_t **payload);
+
+/**
+ * @brief Check if any record is ready to be transmitted.
+ */
+bool trace_tx_ready(trace_tx_t *tx);
+
+/**
+ * @brief Start transmitting if the engine is idle. Safe from any context.
+ */
+void trace_tx_pump(trace_tx_t *tx);
+
+/**
+ * @brief Release the transmitted record and continue with the next one.
+ *        Called from the USART send complete event.
+ */
+void trace_tx_complete(trace_tx_t *tx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TRACE_TX_H_ */
@@ -0,0 +1,71 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+/*
+ * Trace output and shell command of the profiling zones (profiling/alifs_zone.h).
+ * Kept out of trace_shell.c so that only applications using the zones need
+ * alifs_zone.c in their build.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "alifs_zone.h"
+#include "uart_tracelib.h"
+
+void tracelib_zone_report(void)
+{
+    tracef_unlimited("zones %s\n", alifs_zones_enabled ? "on" : "off");
+    tracef_unlimited("zone count min max mean stddev last (us)\n");
+    for (uint32_t i = 0; i < alifs_zone_count(); i++) {
+        const alifs_zone_t *zone = alifs_zone_at(i);
+        const char *off = *zone->enabled ? "" : " (off)";
+        alifs_zone_stats_t stats;
+
+        alifs_zone_get_stats(zone, &stats);
+        if (stats.count == 0) {
+            tracef_unlimited("%s 0%s\n", zone->name, off);
+            continue;
+        }
+
+        const double us = 1e6 / GetSystemCoreClock();
+        const double mean = (double)stats.sum / stats.count;
+        const double var = stats.sum_sq / stats.count - mean * mean;
+        tracef_unlimited("%s %lu %.1f %.1f %.1f %.1f %.1f%s\n", zone->name, (unsigned long)stats.count,
+                         stats.min * us, stats.max * us, mean * us, var > 0.0 ? sqrt(var) * us : 0.0, stats.last * us,
+                         off);
+    }
+}
+
+static void cmd_zones(int argc, char *argv[])
+{
+    const alifs_zone_t *zone = NULL;
+
+    if (argc > 2) {
+        zone = alifs_zone_find(argv[2]);
+        if (zone == NULL) {
+            tracef_unlimited("unknown zone %s\n", argv[2]);
+            return;
+        }
+    }
+    if (argc > 1 && strcmp(argv[1], "reset") == 0) {
+        alifs_zone_reset(zone);
+    } else if (argc > 1 && (strcmp(argv[1], "on") == 0 || strcmp(argv[1], "off") == 0)) {
+        alifs_zone_enable(zone, argv[1][1] == 'n');
+    } else {
+        tracelib_zone_report();
+    }
+}
+
+int tracelib_zone_shell_register(void)
+{
+    return tracelib_shell_register("zones", "[reset|on|off] [name] show, clear or switch profiling zones",
+                                   cmd_zones);
+}
@@ -14,6 +14,37 @@
 #include "board_defs.h"
 #include "uart_tracelib.h"
 
+uint8_t tracelib_module_quiet[TRACELIB_MAX_MODULES];
+
+void tracelib_set_level(uint32_t module, uint32_t level)
+{
+    if (level > TRACE_LEVEL_VERBOSE)
+    {
+        level = TRACE_LEVEL_VERBOSE;
+    }
+
+    if (module == TRACELIB_MAX_MODULES)
+    {
+        for (uint32_t i = 0; i < TRACELIB_MAX_MODULES; i++)
+        {
+            tracelib_module_quiet[i] = TRACE_LEVEL_VERBOSE - level;
+        }
+    }
+    else if (module < TRACELIB_MAX_MODULES)
+    {
+        tracelib_module_quiet[module] = TRACE_LEVEL_VERBOSE - level;
+    }
+}
+
+uint32_t tracelib_get_level(uint32_t module)
+{
+    if (module >= TRACELIB_MAX_MODULES)
+    {
+        return TRACE_LEVEL_NONE;
+    }
+    return TRACE_LEVEL_VERBOSE - tracelib_module_quiet[module];
+}
+
 #if !defined(DISABLE_UART_TRACE)
 #include <stdio.h>
 #include <stdarg.h>
@@ -22,212 +53,1820 @@
 #include <RTE_Components.h>
 #include CMSIS_device_header
 
-/* UART Driver instance */
-static ARM_DRIVER_USART *USARTdrv;
+#include "alifs_profile.h"
+#include "trace_encode.h"
+#include "trace_ring.h"
+#include "trace_recorder.h"
+#include "trace_sink.h"
+#include "trace_tx.h"
+
+/*
+ * UART Driver instance. By default picked at init from the board UART of the
+ * core and kept in the transmit engine. Defining TRACELIB_USART_INSTANCE
+ * binds the driver at compile time instead, the calls here and the sends of
+ * the transmit engine (trace_tx.c) then go directly through the driver's
+ * access structure without loading a pointer first, so LTO can resolve them
+ * to direct calls.
+ */
+#if defined(TRACELIB_USART_INSTANCE)
+extern ARM_DRIVER_USART ARM_Driver_USART_(TRACELIB_USART_INSTANCE);
+#define USARTdrv (&ARM_Driver_USART_(TRACELIB_USART_INSTANCE))
+#else
+#define USARTdrv (tx_main.drv)
+#endif
 
-volatile uint32_t uart_event;
+/*
+ * The state below belongs to the trace UART only, it is all file local. The
+ * output ports (trace_port.c) keep their driver, ring, prefix and callback
+ * in their tracelib_port_t, so they coexist with the trace UART and with
+ * each other.
+ */
 static atomic_bool initialized = false;
-const char * tr_prefix = NULL;
-static bool has_cb = false;
-uint16_t prefix_len;
+static const char * tr_prefix = NULL;
+static ARM_USART_SignalEvent_t user_cb = NULL;
+static uint16_t prefix_len;
 #define MAX_TRACE_LEN 256
 
 #ifndef TRACELIB_UART_BAUDRATE
 #define TRACELIB_UART_BAUDRATE 115200
 #endif
 
-int tracelib_init(const char * prefix, ARM_USART_SignalEvent_t cb_event)
+/*
+ * Negotiate TRACELIB_UART_FAST_BAUDRATE with the host right after init,
+ * staying at TRACELIB_UART_BAUDRATE if the host does not answer in time.
+ */
+#ifndef TRACELIB_BAUD_HANDSHAKE_MS
+#define TRACELIB_BAUD_HANDSHAKE_MS 100
+#endif
+
+static tracelib_timestamp_t ts_mode = TRACELIB_TIMESTAMP_NONE;
+static _Atomic uint32_t ts_last;
+
+/*
+ * Timestamp source for trace lines and records. Cycle counter by default,
+ * A32 cores can use the generic timer with TRACELIB_TIMESTAMP_CNTPCT.
+ */
+__STATIC_FORCEINLINE uint32_t trace_timestamp(void)
 {
-    if (initialized)
+#if defined(A32) && defined(TRACELIB_TIMESTAMP_CNTPCT)
+    return (uint32_t)alifs_profile_cntpct();
+#else
+    return alifs_profile_end(0);
+#endif
+}
+
+/*
+ * Size of the transmit ring buffer in bytes, must be a power of two.
+ * tracef and send_str only copy into this buffer, the USART send complete
+ * event drains it in the background.
+ */
+#ifndef TRACELIB_TX_BUFFER_SIZE
+#define TRACELIB_TX_BUFFER_SIZE 4096
+#endif
+
+#if (TRACELIB_TX_BUFFER_SIZE & (TRACELIB_TX_BUFFER_SIZE - 1)) != 0
+#error "TRACELIB_TX_BUFFER_SIZE must be a power of two"
+#endif
+
+#if TRACELIB_TX_BUFFER_SIZE / 4 < TRACE_REC_MAX_LEN
+#define TX_REC_MAX_LEN      (TRACELIB_TX_BUFFER_SIZE / 4)
+#else
+#define TX_REC_MAX_LEN      TRACE_REC_MAX_LEN
+#endif
+
+#if defined(TRACELIB_CHANNEL_ADDR)
+/*
+ * Shared multi-core log channel. Every core writes its records into its own
+ * ring in shared SRAM at TRACELIB_CHANNEL_ADDR and the core built with
+ * TRACELIB_CHANNEL_DRAIN merges all rings into its UART in timestamp order.
+ * The other cores never touch a UART driver. All cores must use the same
+ * address, TRACELIB_CHANNEL_CORES and TRACELIB_TX_BUFFER_SIZE, and the region
+ * must be mapped non-cacheable.
+ */
+#ifndef TRACELIB_CHANNEL_CORES
+#define TRACELIB_CHANNEL_CORES 4
+#endif
+
+#ifndef TRACELIB_CHANNEL_CORE_ID
+#error "TRACELIB_CHANNEL_CORE_ID must be defined with TRACELIB_CHANNEL_ADDR"
+#endif
+
+#if TRACELIB_CHANNEL_CORE_ID >= TRACELIB_CHANNEL_CORES
+#error "TRACELIB_CHANNEL_CORE_ID out of range"
+#endif
+
+/*
+ * Timestamp the merged stream is ordered by. The default per core cycle count
+ * only orders records of one core, define this to read a system wide counter
+ * to get an exact global order.
+ */
+#ifndef TRACELIB_CHANNEL_TIMESTAMP
+#define TRACELIB_CHANNEL_TIMESTAMP() trace_timestamp()
+#endif
+
+#define TRACELIB_CHANNEL_MAGIC 0x54524348UL
+
+typedef struct {
+    volatile uint32_t magic;    // set by the owning core once its ring is usable
+    trace_ring_t ring;
+    uint8_t buf[TRACELIB_TX_BUFFER_SIZE] __ALIGNED(4);
+} tracelib_channel_slot_t;
+
+#define TRACELIB_CHANNEL ((tracelib_channel_slot_t *)(TRACELIB_CHANNEL_ADDR))
+
+#if !defined(TRACELIB_CHANNEL_DRAIN)
+#define TX_REMOTE_CORE
+#endif
+
+#else
+static uint8_t tx_buf[TRACELIB_TX_BUFFER_SIZE] __ALIGNED(4);
+static trace_ring_t tx_local_ring = { .size = TRACELIB_TX_BUFFER_SIZE, .buf = tx_buf };
+#endif // TRACELIB_CHANNEL_ADDR
+
+#ifndef TRACELIB_SINKS
+#define TRACELIB_SINKS TRACELIB_SINK_UART
+#endif
+
+/*
+ * Transmit engine of the trace UART, shared with the output ports (see
+ * trace_tx.c). The ring is the channel slot of the core with
+ * TRACELIB_CHANNEL_ADDR, set by tracelib_init.
+ */
+static trace_tx_t tx_main = {
+#if defined(TRACELIB_USART_INSTANCE)
+    .drv = USARTdrv,
+#endif
+#if !defined(TRACELIB_CHANNEL_ADDR)
+    .ring = &tx_local_ring,
+#endif
+    .sinks = TRACELIB_SINKS,
+};
+
+#if !defined(TX_REMOTE_CORE)
+
+/*
+ * Batched output. While the batch threshold is set the UART is powered down
+ * between bursts, output accumulates in the ring until threshold bytes are
+ * queued, the oldest output is timeout_ms old or tracelib_flush is called.
+ * tracelib_process powers the UART down once a burst has been sent, so it
+ * has to be called periodically (idle loop) in this mode.
+ */
+#ifndef TRACELIB_BATCH_THRESHOLD
+#define TRACELIB_BATCH_THRESHOLD 0
+#endif
+
+#ifndef TRACELIB_BATCH_TIMEOUT_MS
+#define TRACELIB_BATCH_TIMEOUT_MS 100
+#endif
+
+static uint32_t batch_threshold = TRACELIB_BATCH_THRESHOLD;
+static uint32_t batch_timeout_ms = TRACELIB_BATCH_TIMEOUT_MS;
+static atomic_bool batch_pending;           // output is waiting for the next burst
+static uint32_t batch_first;                // cycle count of the oldest waiting output
+static atomic_bool tx_powered;              // UART is powered up
+
+/* UART power duty cycle, accumulated from the deltas between samples */
+static atomic_flag duty_lock = ATOMIC_FLAG_INIT;
+static uint32_t duty_last;
+static volatile uint64_t duty_elapsed;
+static volatile uint64_t duty_on;
+static atomic_bool duty_reset;              // tracelib_reset_stats, applied by the next sample
+static _Atomic uint32_t tx_power_ups;
+
+static bool tx_power_up(void);
+#endif
+
+static _Atomic uint32_t tr_depth;       // number of vtracef calls in progress
+static _Atomic uint32_t tr_context_calls[TRACELIB_CONTEXT_COUNT];
+static _Atomic uint32_t tr_suppressed;  // tracef calls dropped by rate limiting
+
+#if defined(TRACELIB_MEASURE)
+/* Per call cycle counts for tracelib_get_stats, see tracelib_latency_t */
+typedef struct {
+    _Atomic uint32_t calls;
+    _Atomic uint32_t total_cycles;
+    _Atomic uint32_t max_cycles;
+} latency_counter_t;
+
+static latency_counter_t tr_tracef_latency;
+static latency_counter_t tr_send_latency;
+
+static void latency_update(latency_counter_t *counter, uint32_t cycles)
+{
+    atomic_fetch_add_explicit(&counter->calls, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&counter->total_cycles, cycles, memory_order_relaxed);
+
+    uint32_t max = atomic_load_explicit(&counter->max_cycles, memory_order_relaxed);
+    while (cycles > max &&
+           !atomic_compare_exchange_weak_explicit(&counter->max_cycles, &max, cycles,
+                                                  memory_order_relaxed, memory_order_relaxed));
+}
+
+static void latency_get(latency_counter_t *counter, tracelib_latency_t *latency)
+{
+    latency->calls = atomic_load_explicit(&counter->calls, memory_order_relaxed);
+    latency->total_cycles = atomic_load_explicit(&counter->total_cycles, memory_order_relaxed);
+    latency->max_cycles = atomic_load_explicit(&counter->max_cycles, memory_order_relaxed);
+}
+
+static void latency_reset(latency_counter_t *counter)
+{
+    atomic_store_explicit(&counter->calls, 0, memory_order_relaxed);
+    atomic_store_explicit(&counter->total_cycles, 0, memory_order_relaxed);
+    atomic_store_explicit(&counter->max_cycles, 0, memory_order_relaxed);
+}
+#endif // TRACELIB_MEASURE
+
+__STATIC_FORCEINLINE bool in_interrupt(void)
+{
+#ifdef A32
+    return (__get_mode() == CPSR_M_IRQ || __get_mode() == CPSR_M_FIQ);
+#else
+    return __get_IPSR() != 0U;
+#endif
+}
+
+__STATIC_FORCEINLINE bool irq_disabled(void)
+{
+#ifdef A32
+    return (__get_CPSR() & CPSR_I_Msk) != 0U;
+#else
+    return __get_PRIMASK() != 0U;
+#endif
+}
+
+/*
+ * Timeout bookkeeping for the blocking reads and writes, counts whole
+ * milliseconds from the cycle counter so long timeouts do not overflow.
+ */
+typedef struct {
+    uint32_t last;
+    uint32_t elapsed_ms;
+} wait_timer_t;
+
+static bool timed_out(wait_timer_t *timer, uint32_t timeout_ms)
+{
+    if (timeout_ms == TRACELIB_WAIT_FOREVER) {
+        return false;
+    }
+
+    const uint32_t cycles_per_ms = GetSystemCoreClock() / 1000;
+    const uint32_t now = alifs_profile_end(0);
+    while (now - timer->last >= cycles_per_ms) {
+        timer->last += cycles_per_ms;
+        timer->elapsed_ms++;
+    }
+    return timer->elapsed_ms >= timeout_ms;
+}
+
+#if defined(TRACELIB_CHANNEL_ADDR) && !defined(TX_REMOTE_CORE)
+/*
+ * Find the next committed record to transmit, the record with the oldest
+ * timestamp among all cores of the shared channel.
+ */
+static trace_ring_t *channel_next(uint32_t *hdr, uint8_t **payload)
+{
+    trace_ring_t *oldest = NULL;
+    uint32_t oldest_ts = 0;
+
+    for (uint32_t core = 0; core < TRACELIB_CHANNEL_CORES; core++) {
+        tracelib_channel_slot_t *slot = &TRACELIB_CHANNEL[core];
+        if (slot->magic != TRACELIB_CHANNEL_MAGIC) {
+            continue;
+        }
+
+        uint32_t value;
+        uint8_t *data = trace_ring_peek(&slot->ring, &value);
+        if (data == NULL) {
+            continue;
+        }
+
+        const uint32_t ts = *trace_ring_meta(data);
+        if (oldest == NULL || (int32_t)(ts - oldest_ts) < 0) {
+            oldest = &slot->ring;
+            oldest_ts = ts;
+            *hdr = value;
+            *payload = data;
+        }
+    }
+    return oldest;
+}
+
+/*
+ * Check if any core of the shared channel has a record ready to be transmitted.
+ */
+static bool channel_ready(void)
+{
+    for (uint32_t core = 0; core < TRACELIB_CHANNEL_CORES; core++) {
+        tracelib_channel_slot_t *slot = &TRACELIB_CHANNEL[core];
+        if (slot->magic == TRACELIB_CHANNEL_MAGIC && trace_ring_ready(&slot->ring)) {
+            return true;
+        }
+    }
+    return false;
+}
+#endif // TRACELIB_CHANNEL_ADDR && !TX_REMOTE_CORE
+
+#if !defined(TX_REMOTE_CORE)
+static const trace_tx_ops_t tx_main_ops = {
+#if defined(TRACELIB_CHANNEL_ADDR)
+    .next = channel_next,
+    .ready = channel_ready,
+#endif
+    .power_up = tx_power_up,
+};
+#endif
+
+/*
+ * Start draining the ring if the transmitter is idle.
+ */
+static void tx_pump(void)
+{
+#if !defined(TX_REMOTE_CORE)
+    trace_tx_pump(&tx_main);
+#endif
+}
+
+#if !defined(TX_REMOTE_CORE)
+/*
+ * Sample the cycle counter for the UART duty cycle. Has to run at least
+ * once per counter wrap, which every kick and tracelib_process do.
+ */
+static void duty_update(void)
+{
+    if (atomic_flag_test_and_set_explicit(&duty_lock, memory_order_acquire)) {
+        // another context is sampling, the delta is counted next time
+        return;
+    }
+
+    const uint32_t now = alifs_profile_end(0);
+    const uint32_t delta = now - duty_last;
+    duty_last = now;
+    if (atomic_exchange_explicit(&duty_reset, false, memory_order_relaxed)) {
+        duty_elapsed = 0;
+        duty_on = 0;
+    }
+    duty_elapsed += delta;
+    if (atomic_load_explicit(&tx_powered, memory_order_relaxed)) {
+        duty_on += delta;
+    }
+    atomic_flag_clear_explicit(&duty_lock, memory_order_release);
+}
+
+/*
+ * Check if the output waiting for a powered down UART should go out now.
+ */
+static bool batch_due(void)
+{
+    if (batch_threshold == 0 || atomic_load_explicit(&tx_powered, memory_order_relaxed)) {
+        return true;
+    }
+
+    const uint32_t used = atomic_load_explicit(&tx_main.ring->head, memory_order_relaxed) -
+                          atomic_load_explicit(&tx_main.ring->tail, memory_order_relaxed);
+    if (used >= batch_threshold) {
+        return true;
+    }
+
+    if (!atomic_exchange_explicit(&batch_pending, true, memory_order_relaxed)) {
+        batch_first = alifs_profile_end(0);
+        return false;
+    }
+    return alifs_profile_end(batch_first) / (GetSystemCoreClock() / 1000) >= batch_timeout_ms;
+}
+#endif
+
+/*
+ * Start the transmitter after a commit. With TRACELIB_DEFER_ISR_KICK the USART
+ * driver is not touched from ISRs or with IRQs disabled, the kick is left to
+ * tracelib_process (idle hook) or PendSV with TRACELIB_PENDSV_KICK instead.
+ * A32 has no PendSV, there it is always tracelib_process. Records committed
+ * while a transmission is ongoing go out from the send complete event either
+ * way.
+ */
+static void tx_kick(void)
+{
+#if defined(TRACELIB_DEFER_ISR_KICK)
+    if (in_interrupt() || irq_disabled())
     {
-        return 0;
+#if defined(TRACELIB_PENDSV_KICK) && !defined(A32)
+        SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+#endif
+        return;
     }
-    int32_t ret    = 0;
-#if defined(M55_HE) || defined(M55_HE_E1C) || defined(RTSS_HE)
-#if defined(CUSTOM_HE_UART)
-    extern ARM_DRIVER_USART ARM_Driver_USART_(CUSTOM_HE_UART);
-    USARTdrv = &ARM_Driver_USART_(CUSTOM_HE_UART);
-#else
-#ifdef BOARD_UART1_INSTANCE
-    extern ARM_DRIVER_USART ARM_Driver_USART_(BOARD_UART1_INSTANCE);
-    USARTdrv = &ARM_Driver_USART_(BOARD_UART1_INSTANCE);
-#elif defined(BOARD_UARTA_UART_INSTANCE)
-    extern ARM_DRIVER_USART ARM_Driver_USART_(BOARD_UARTA_UART_INSTANCE);
-    USARTdrv = &ARM_Driver_USART_(BOARD_UARTA_UART_INSTANCE);
-#endif // BOARD_UART1_INSTANCE
-#endif // CUSTOM_HE_UART
-#elif defined(M55_HP) || defined(RTSS_HP)
-#ifdef BOARD_UART2_INSTANCE
-    extern ARM_DRIVER_USART ARM_Driver_USART_(BOARD_UART2_INSTANCE);
-    USARTdrv = &ARM_Driver_USART_(BOARD_UART2_INSTANCE);
-#elif defined(BOARD_UARTB_UART_INSTANCE)
-    extern ARM_DRIVER_USART ARM_Driver_USART_(BOARD_UARTB_UART_INSTANCE);
-    USARTdrv = &ARM_Driver_USART_(BOARD_UARTB_UART_INSTANCE);
 #endif
-#elif defined(A32)
-    int cpuid = __get_MPIDR() & 0xFF;
-    switch (cpuid) {
-    case 0: {
-#ifdef BOARD_UART3_INSTANCE
-        extern ARM_DRIVER_USART ARM_Driver_USART_(BOARD_UART3_INSTANCE);
-        USARTdrv = &ARM_Driver_USART_(BOARD_UART3_INSTANCE);
-        break;
-#elif defined(BOARD_UARTC_UART_INSTANCE)
-        extern ARM_DRIVER_USART ARM_Driver_USART_(BOARD_UARTC_UART_INSTANCE);
-        USARTdrv = &ARM_Driver_USART_(BOARD_UARTC_UART_INSTANCE);
-        break;
+#if !defined(TX_REMOTE_CORE)
+    duty_update();
+    if (!batch_due()) {
+        return;
+    }
+#endif
+    tx_pump();
+}
+
+static uint8_t *tx_reserve(uint32_t len, uint32_t *rec)
+{
+    uint8_t *dst = trace_ring_reserve(tx_main.ring, len, rec);
+#if defined(TRACELIB_CHANNEL_ADDR)
+    if (dst) {
+        *trace_ring_meta(dst) = TRACELIB_CHANNEL_TIMESTAMP();
+    }
 #endif
+    return dst;
+}
+
+static void tx_commit(uint32_t rec, uint32_t reserved, uint32_t len)
+{
+    // before the commit, the drain may release the record right after it
+    trace_recorder_write(trace_ring_payload(tx_main.ring, rec), len);
+    trace_ring_commit(tx_main.ring, rec, reserved, len, 0);
+    tx_kick();
+}
+
+/*
+ * Queue a copy of data as one record. A full ring drops it and counts len.
+ */
+static bool tx_write(const void *data, uint32_t len)
+{
+    uint32_t rec;
+    uint8_t *dst = tx_reserve(len, &rec);
+    if (dst == NULL)
+    {
+        return false;
     }
+    memcpy(dst, data, len);
+    tx_commit(rec, len, len);
+    return true;
+}
 
-    case 1: {
-#ifdef BOARD_UART4_INSTANCE
-        extern ARM_DRIVER_USART ARM_Driver_USART_(BOARD_UART4_INSTANCE);
-        USARTdrv = &ARM_Driver_USART_(BOARD_UART4_INSTANCE);
-        break;
-#elif defined(BOARD_UARTD_UART_INSTANCE)
-        extern ARM_DRIVER_USART ARM_Driver_USART_(BOARD_UARTD_UART_INSTANCE);
-        USARTdrv = &ARM_Driver_USART_(BOARD_UARTD_UART_INSTANCE);
-        break;
+#if !defined(TX_REMOTE_CORE)
+/*
+ * Receive path. The driver receives one byte at a time into rx_byte and every
+ * receive complete event moves it into the rx ring and re-arms the receive,
+ * so the UART is always listening without a core spinning on it. The ring has
+ * a single producer (the UART ISR) and a single consumer, which is either the
+ * reading thread or rx_service while an asynchronous receive_str is pending.
+ */
+#if (TRACELIB_RX_BUFFER_SIZE & (TRACELIB_RX_BUFFER_SIZE - 1)) != 0
+#error "TRACELIB_RX_BUFFER_SIZE must be a power of two"
 #endif
+
+#define RX_BUF_MASK (TRACELIB_RX_BUFFER_SIZE - 1)
+#define RX_ERROR_EVENTS (ARM_USART_EVENT_RX_OVERFLOW | ARM_USART_EVENT_RX_BREAK | \
+                         ARM_USART_EVENT_RX_FRAMING_ERROR | ARM_USART_EVENT_RX_PARITY_ERROR)
+
+static uint8_t rx_buf[TRACELIB_RX_BUFFER_SIZE];
+static _Atomic uint32_t rx_head;        // advanced by the UART ISR
+static _Atomic uint32_t rx_tail;        // advanced by the reader
+static _Atomic uint32_t rx_overflow;    // bytes lost because the ring was full
+static uint8_t rx_byte;
+
+/* Pending asynchronous receive_str request, filled by rx_service */
+static char *rx_req_buf;
+static uint32_t rx_req_len;
+static uint32_t rx_req_count;
+static atomic_bool rx_req_active;
+static atomic_bool rx_serving;
+
+static void rx_start(void)
+{
+    (void)USARTdrv->Receive(&rx_byte, 1);
+}
+
+static uint32_t rx_available(void)
+{
+    return atomic_load_explicit(&rx_head, memory_order_acquire) -
+           atomic_load_explicit(&rx_tail, memory_order_relaxed);
+}
+
+static uint32_t rx_ring_read(char *dst, uint32_t len)
+{
+    uint32_t tail = atomic_load_explicit(&rx_tail, memory_order_relaxed);
+    uint32_t count = rx_available();
+
+    if (count > len) {
+        count = len;
     }
-    default:
-        return ARM_DRIVER_ERROR_UNSUPPORTED;
+    for (uint32_t i = 0; i < count; i++) {
+        dst[i] = rx_buf[(tail + i) & RX_BUF_MASK];
+    }
+    atomic_store_explicit(&rx_tail, tail + count, memory_order_release);
+    return count;
+}
+
+/*
+ * Move received bytes into a pending receive_str request and signal
+ * ARM_USART_EVENT_RECEIVE_COMPLETE to the application when it is full.
+ */
+static void rx_service(void)
+{
+    while (!atomic_exchange_explicit(&rx_serving, true, memory_order_acquire)) {
+        bool done = false;
+
+        if (atomic_load_explicit(&rx_req_active, memory_order_acquire)) {
+            rx_req_count += rx_ring_read(rx_req_buf + rx_req_count, rx_req_len - rx_req_count);
+            if (rx_req_count == rx_req_len) {
+                atomic_store_explicit(&rx_req_active, false, memory_order_release);
+                done = true;
+            }
+        }
+        atomic_store_explicit(&rx_serving, false, memory_order_release);
+
+        if (done && user_cb) {
+            user_cb(ARM_USART_EVENT_RECEIVE_COMPLETE);
+        }
+
+        // a byte may have arrived while another context was serving
+        if (!atomic_load_explicit(&rx_req_active, memory_order_acquire) || rx_available() == 0) {
+            return;
+        }
+    }
+}
+
+static void rx_complete(void)
+{
+    const uint32_t head = atomic_load_explicit(&rx_head, memory_order_relaxed);
+
+    if (head - atomic_load_explicit(&rx_tail, memory_order_acquire) < TRACELIB_RX_BUFFER_SIZE) {
+        rx_buf[head & RX_BUF_MASK] = rx_byte;
+        atomic_store_explicit(&rx_head, head + 1, memory_order_release);
+    } else {
+        atomic_fetch_add_explicit(&rx_overflow, 1, memory_order_relaxed);
+    }
+    rx_start();
+    rx_service();
+}
+
+static uint32_t tr_baudrate = TRACELIB_UART_BAUDRATE;
+
+/*
+ * Set the frame format and baud rate and enable both lines. Also used to
+ * switch the rate at runtime, so the lines are enabled again explicitly.
+ */
+static int32_t uart_configure(uint32_t baudrate)
+{
+    int32_t ret;
+
+    ret =  USARTdrv->Control(ARM_USART_MODE_ASYNCHRONOUS |
+                             ARM_USART_DATA_BITS_8       |
+                             ARM_USART_PARITY_NONE       |
+                             ARM_USART_STOP_BITS_1       |
+                             ARM_USART_FLOW_CONTROL_NONE, baudrate);
+    if (ret != ARM_DRIVER_OK) {
+        return ret;
     }
+
+    /* Transmitter line */
+    ret =  USARTdrv->Control(ARM_USART_CONTROL_TX, 1);
+    if (ret != ARM_DRIVER_OK) {
+        return ret;
+    }
+
+    /* Receiver line */
+    return USARTdrv->Control(ARM_USART_CONTROL_RX, 1);
+}
+
+/*
+ * Power the UART up for a burst if anything is waiting. Called with the busy
+ * token held.
+ */
+static bool tx_power_up(void)
+{
+    if (atomic_load_explicit(&tx_powered, memory_order_relaxed)) {
+        return true;
+    }
+    if (!trace_tx_ready(&tx_main)) {
+        return false;
+    }
+
+    duty_update();
+    if (USARTdrv->PowerControl(ARM_POWER_FULL) != ARM_DRIVER_OK ||
+        uart_configure(tr_baudrate) != ARM_DRIVER_OK) {
+        return false;
+    }
+    rx_start();
+    atomic_store_explicit(&batch_pending, false, memory_order_relaxed);
+    atomic_store_explicit(&tx_powered, true, memory_order_relaxed);
+    atomic_fetch_add_explicit(&tx_power_ups, 1, memory_order_relaxed);
+    return true;
+}
+
+/*
+ * Power the UART down after a burst. The send complete event can come before
+ * the transmit FIFO is empty, so the UART is only switched off after it has
+ * been idle for a FIFO worth of character times.
+ */
+static void tx_power_down(void)
+{
+    if (batch_threshold == 0 || !atomic_load_explicit(&tx_powered, memory_order_relaxed)) {
+        return;
+    }
+
+    const uint32_t guard = GetSystemCoreClock() / tr_baudrate * 10 * 32;
+    if (atomic_exchange_explicit(&tx_main.busy, true, memory_order_acquire)) {
+        return;
+    }
+    if (!trace_tx_ready(&tx_main) && alifs_profile_end(tx_main.idle_since) >= guard && !USARTdrv->GetStatus().tx_busy) {
+        duty_update();
+        (void)USARTdrv->Control(ARM_USART_ABORT_RECEIVE, 0);
+        if (USARTdrv->PowerControl(ARM_POWER_OFF) == ARM_DRIVER_OK) {
+            atomic_store_explicit(&tx_powered, false, memory_order_relaxed);
+        }
+    }
+    atomic_store_explicit(&tx_main.busy, false, memory_order_release);
+}
+
+static void tracelib_uart_event(uint32_t event)
+{
+    if (event & ARM_USART_EVENT_SEND_COMPLETE) {
+        trace_tx_complete(&tx_main);
+    }
+
+    if (event & ARM_USART_EVENT_RECEIVE_COMPLETE) {
+        // internal single byte receive, the application sees it completing receive_str
+        event &= ~ARM_USART_EVENT_RECEIVE_COMPLETE;
+        rx_complete();
+    }
+
+    if ((event & RX_ERROR_EVENTS) && !USARTdrv->GetStatus().rx_busy) {
+        rx_start();
+    }
+
+    if (user_cb && event) {
+        user_cb(event);
+    }
+}
+#endif // !TX_REMOTE_CORE
+
+int tracelib_init(const char * prefix, ARM_USART_SignalEvent_t cb_event)
+{
+    if (initialized)
+    {
+        return 0;
+    }
+    int32_t ret    = 0;
+
+#if defined(TRACELIB_CHANNEL_ADDR)
+    /* Claim this core's slot of the shared channel */
+    tracelib_channel_slot_t *slot = &TRACELIB_CHANNEL[TRACELIB_CHANNEL_CORE_ID];
+    slot->magic = 0;
+    __DMB();
+    memset(slot->buf, 0, sizeof(slot->buf));
+    trace_ring_init(&slot->ring, slot->buf, sizeof(slot->buf));
+    __DMB();
+    slot->magic = TRACELIB_CHANNEL_MAGIC;
+    tx_main.ring = &slot->ring;
+#endif
+
+    /* Pick up the recorded output from before a reset, if any */
+    trace_recorder_init();
+
+#if !defined(TX_REMOTE_CORE) && !defined(TRACELIB_USART_INSTANCE)
+#if defined(M55_HE) || defined(M55_HE_E1C) || defined(RTSS_HE)
+#if defined(CUSTOM_HE_UART)
+    extern ARM_DRIVER_USART ARM_Driver_USART_(CUSTOM_HE_UART);
+    USARTdrv = &ARM_Driver_USART_(CUSTOM_HE_UART);
+#else
+#ifdef BOARD_UART1_INSTANCE
+    extern ARM_DRIVER_USART ARM_Driver_USART_(BOARD_UART1_INSTANCE);
+    USARTdrv = &ARM_Driver_USART_(BOARD_UART1_INSTANCE);
+#elif defined(BOARD_UARTA_UART_INSTANCE)
+    extern ARM_DRIVER_USART ARM_Driver_USART_(BOARD_UARTA_UART_INSTANCE);
+    USARTdrv = &ARM_Driver_USART_(BOARD_UARTA_UART_INSTANCE);
+#endif // BOARD_UART1_INSTANCE
+#endif // CUSTOM_HE_UART
+#elif defined(M55_HP) || defined(RTSS_HP)
+#ifdef BOARD_UART2_INSTANCE
+    extern ARM_DRIVER_USART ARM_Driver_USART_(BOARD_UART2_INSTANCE);
+    USARTdrv = &ARM_Driver_USART_(BOARD_UART2_INSTANCE);
+#elif defined(BOARD_UARTB_UART_INSTANCE)
+    extern ARM_DRIVER_USART ARM_Driver_USART_(BOARD_UARTB_UART_INSTANCE);
+    USARTdrv = &ARM_Driver_USART_(BOARD_UARTB_UART_INSTANCE);
+#endif
+#elif defined(A32)
+    int cpuid = __get_MPIDR() & 0xFF;
+    switch (cpuid) {
+    case 0: {
+#ifdef BOARD_UART3_INSTANCE
+        extern ARM_DRIVER_USART ARM_Driver_USART_(BOARD_UART3_INSTANCE);
+        USARTdrv = &ARM_Driver_USART_(BOARD_UART3_INSTANCE);
+        break;
+#elif defined(BOARD_UARTC_UART_INSTANCE)
+        extern ARM_DRIVER_USART ARM_Driver_USART_(BOARD_UARTC_UART_INSTANCE);
+        USARTdrv = &ARM_Driver_USART_(BOARD_UARTC_UART_INSTANCE);
+        break;
+#endif
+    }
+
+    case 1: {
+#ifdef BOARD_UART4_INSTANCE
+        extern ARM_DRIVER_USART ARM_Driver_USART_(BOARD_UART4_INSTANCE);
+        USARTdrv = &ARM_Driver_USART_(BOARD_UART4_INSTANCE);
+        break;
+#elif defined(BOARD_UARTD_UART_INSTANCE)
+        extern ARM_DRIVER_USART ARM_Driver_USART_(BOARD_UARTD_UART_INSTANCE);
+        USARTdrv = &ARM_Driver_USART_(BOARD_UARTD_UART_INSTANCE);
+        break;
+#endif
+    }
+    default:
+        return ARM_DRIVER_ERROR_UNSUPPORTED;
+    }
+#else
+    #error "Undefined CPU!"
+#endif
+#endif // !TX_REMOTE_CORE && !TRACELIB_USART_INSTANCE
+
+    /* Make sure the cycle counter used for timestamps is running */
+    (void)alifs_profile_start();
+
+    tr_prefix = prefix;
+    if (tr_prefix)
+    {
+        prefix_len = strlen(tr_prefix);
+    }
+    else
+    {
+        prefix_len = 0;
+    }
+
+#if defined(TX_REMOTE_CORE)
+    /* The drain core transmits the records of this core */
+    (void)cb_event;
+    (void)ret;
+    initialized = true;
+    return 0;
+#else
+    /* Initialize UART driver, send complete events drive the transmit ring */
+    user_cb = cb_event;
+    tx_main.ops = &tx_main_ops;
+    ret = USARTdrv->Initialize(tracelib_uart_event);
+    if (ret != ARM_DRIVER_OK)
+    {
+        return ret;
+    }
+
+    /* Power up UART peripheral */
+    ret = USARTdrv->PowerControl(ARM_POWER_FULL);
+    if (ret != ARM_DRIVER_OK)
+    {
+        return ret;
+    }
+
+    tr_baudrate = TRACELIB_UART_BAUDRATE;
+    ret = uart_configure(tr_baudrate);
+    if (ret != ARM_DRIVER_OK)
+    {
+        return ret;
+    }
+    duty_last = alifs_profile_end(0);
+    atomic_store_explicit(&tx_powered, true, memory_order_relaxed);
+
+    /* Keep receiving into the rx ring in the background */
+    atomic_store_explicit(&rx_req_active, false, memory_order_relaxed);
+    rx_start();
+
+#if defined(TRACELIB_PENDSV_KICK) && !defined(A32)
+    NVIC_SetPriority(PendSV_IRQn, (1UL << __NVIC_PRIO_BITS) - 1UL);
+#endif
+
+    initialized = true;
+
+#if defined(TRACELIB_UART_FAST_BAUDRATE)
+    /* Falls back to TRACELIB_UART_BAUDRATE without a host answering */
+    (void)tracelib_set_baudrate(TRACELIB_UART_FAST_BAUDRATE, TRACELIB_BAUD_HANDSHAKE_MS);
+#endif
+    return ret;
+#endif // TX_REMOTE_CORE
+}
+
+int tracelib_uninit()
+{
+    int32_t ret = 0;
+    if (initialized)
+    {
+        /* Let the queued output go out before the UART is powered down */
+        tracelib_flush();
+        initialized = false;
+
+#if !defined(TX_REMOTE_CORE)
+        (void)USARTdrv->Control(ARM_USART_ABORT_RECEIVE, 0);
+
+        /* Power down UART peripheral */
+        if (atomic_exchange_explicit(&tx_powered, false, memory_order_relaxed))
+        {
+            ret = USARTdrv->PowerControl(ARM_POWER_OFF);
+            if (ret != ARM_DRIVER_OK)
+            {
+                return ret;
+            }
+        }
+
+        ret = USARTdrv->Uninitialize();
+        if (ret != ARM_DRIVER_OK)
+        {
+            return ret;
+        }
+#endif
+    }
+    return ret;
+}
+
+int receive_str(char* str, uint32_t len)
+{
+    int ret = 0;
+#if defined(TX_REMOTE_CORE)
+    (void)str;
+    (void)len;
+    ret = ARM_DRIVER_ERROR_UNSUPPORTED;
+#else
+    if (initialized)
+    {
+        if (atomic_load_explicit(&rx_req_active, memory_order_acquire))
+        {
+            return ARM_DRIVER_ERROR_BUSY;
+        }
+        if (user_cb)
+        {
+            /* Completed asynchronously, the callback gets ARM_USART_EVENT_RECEIVE_COMPLETE */
+            rx_req_buf = str;
+            rx_req_len = len;
+            rx_req_count = 0;
+            atomic_store_explicit(&rx_req_active, true, memory_order_release);
+            rx_service();
+        }
+        else
+        {
+            uint32_t count = 0;
+            while (count < len)
+            {
+                count += rx_ring_read(str + count, len - count);
+                if (count < len)
+                {
+                    __WFE();
+                }
+            }
+        }
+    } else {
+        ret = -1;
+    }
+#endif
+    return ret;
+}
+
+int tracelib_read(char* buf, uint32_t len, uint32_t timeout_ms)
+{
+#if defined(TX_REMOTE_CORE)
+    (void)buf;
+    (void)len;
+    (void)timeout_ms;
+    return ARM_DRIVER_ERROR_UNSUPPORTED;
+#else
+    if (!initialized)
+    {
+        return ARM_DRIVER_ERROR;
+    }
+    if (atomic_load_explicit(&rx_req_active, memory_order_acquire))
+    {
+        return ARM_DRIVER_ERROR_BUSY;
+    }
+
+    wait_timer_t timer = { .last = alifs_profile_end(0) };
+    while (rx_available() == 0)
+    {
+        if (timeout_ms == 0 || timed_out(&timer, timeout_ms))
+        {
+            return 0;
+        }
+        __WFE();
+    }
+    return rx_ring_read(buf, len);
+#endif
+}
+
+int tracelib_read_line(char* buf, uint32_t size, uint32_t timeout_ms)
+{
+#if defined(TX_REMOTE_CORE)
+    (void)buf;
+    (void)size;
+    (void)timeout_ms;
+    return ARM_DRIVER_ERROR_UNSUPPORTED;
+#else
+    if (!initialized || size == 0)
+    {
+        return ARM_DRIVER_ERROR;
+    }
+    if (atomic_load_explicit(&rx_req_active, memory_order_acquire))
+    {
+        return ARM_DRIVER_ERROR_BUSY;
+    }
+
+    /*
+     * Only consume once a whole line has been received, or as much of it as
+     * fits into buf or into the receive ring, which cannot take more of it
+     */
+    const uint32_t max_len = size - 1 < TRACELIB_RX_BUFFER_SIZE ? size - 1 : TRACELIB_RX_BUFFER_SIZE;
+    wait_timer_t timer = { .last = alifs_profile_end(0) };
+    uint32_t scanned = 0;
+    for (;;)
+    {
+        const uint32_t tail = atomic_load_explicit(&rx_tail, memory_order_relaxed);
+        const uint32_t available = rx_available();
+
+        while (scanned < available && scanned < max_len)
+        {
+            if (rx_buf[(tail + scanned) & RX_BUF_MASK] == '\n')
+            {
+                break;
+            }
+            scanned++;
+        }
+        if (scanned < available || scanned == max_len)
+        {
+            break;
+        }
+        if (timeout_ms == 0 || timed_out(&timer, timeout_ms))
+        {
+            return ARM_DRIVER_ERROR_TIMEOUT;
+        }
+        __WFE();
+    }
+
+    uint32_t len = rx_ring_read(buf, scanned);
+    if (scanned < max_len)
+    {
+        char eol;
+        (void)rx_ring_read(&eol, 1);
+    }
+    if (len && buf[len - 1] == '\r')
+    {
+        len--;
+    }
+    buf[len] = '\0';
+    return len;
+#endif
+}
+
+void tracelib_get_rx_stats(uint32_t *available, uint32_t *overflow)
+{
+#if defined(TX_REMOTE_CORE)
+    *available = 0;
+    *overflow = 0;
+#else
+    *available = rx_available();
+    *overflow = atomic_load_explicit(&rx_overflow, memory_order_relaxed);
+#endif
+}
+
+static int send_chunks(const char* str, uint32_t len)
+{
+    bool queued = false;
+    while (len)
+    {
+        const uint32_t chunk = len < TX_REC_MAX_LEN ? len : TX_REC_MAX_LEN;
+        if (!tx_write(str, chunk))
+        {
+            if (!queued)
+            {
+                // nothing was queued so the caller may safely retry
+                return ARM_DRIVER_ERROR_BUSY;
+            }
+            // the tail of a partially queued string is accounted as dropped
+            atomic_fetch_add_explicit(&tx_main.ring->dropped, len - chunk, memory_order_relaxed);
+            break;
+        }
+        queued = true;
+        str += chunk;
+        len -= chunk;
+    }
+    return ARM_DRIVER_OK;
+}
+
+int send_str(const char* str, uint32_t len)
+{
+    int ret = 0;
+
+    if (initialized)
+    {
+#if defined(TRACELIB_MEASURE)
+        const uint32_t start = alifs_profile_end(0);
+#endif
+        ret = send_chunks(str, len);
+#if defined(TRACELIB_MEASURE)
+        latency_update(&tr_send_latency, alifs_profile_end(start));
+#endif
+    }
+    return ret;
+}
+
+int tracelib_write(const char* str, uint32_t len, uint32_t timeout_ms)
+{
+    uint32_t written = 0;
+
+    if (!initialized)
+    {
+        return 0;
+    }
+
+#if defined(TRACELIB_MEASURE)
+    const uint32_t start = alifs_profile_end(0);
+#endif
+    // the send complete event that makes room can not come here
+    bool wait = !in_interrupt() && !irq_disabled();
+    wait_timer_t timer = { .last = alifs_profile_end(0) };
+    while (written < len)
+    {
+        const uint32_t chunk = len - written < TX_REC_MAX_LEN ? len - written : TX_REC_MAX_LEN;
+
+        // wait before reserving, a failed reservation counts as dropped
+        while (wait && !trace_ring_fits(tx_main.ring, chunk))
+        {
+            if (timeout_ms == 0 || timed_out(&timer, timeout_ms))
+            {
+                wait = false;
+                break;
+            }
+            tx_pump();
+            __WFE();
+        }
+        if (!tx_write(str + written, chunk))
+        {
+            atomic_fetch_add_explicit(&tx_main.ring->dropped, len - written - chunk, memory_order_relaxed);
+            break;
+        }
+        written += chunk;
+    }
+#if defined(TRACELIB_MEASURE)
+    latency_update(&tr_send_latency, alifs_profile_end(start));
+#endif
+    return written;
+}
+
+#if !defined(TX_REMOTE_CORE)
+static atomic_bool tx_polled;   // the ring was given up for polled output
+
+static void tx_send_polled(const void *data, uint32_t len)
+{
+    const uint32_t sinks = atomic_load_explicit(&tx_main.sinks, memory_order_relaxed);
+
+    trace_sink_write(sinks & ~TRACELIB_SINK_UART, data, len);
+    if ((sinks & TRACELIB_SINK_UART) && len && USARTdrv->Send(data, len) == ARM_DRIVER_OK)
+    {
+        while (USARTdrv->GetTxCount() != len);
+    }
+    atomic_fetch_add_explicit(&tx_main.sent, len, memory_order_relaxed);
+}
+
+/*
+ * Give up the interrupt driven transmit path for good. Holding the busy
+ * token keeps tx_pump and the send complete event away from the driver, the
+ * interrupted transmission is aborted and its record is sent again from the
+ * start.
+ */
+static void tx_abandon(void)
+{
+    if (atomic_exchange_explicit(&tx_main.busy, true, memory_order_acquire))
+    {
+        (void)USARTdrv->Control(ARM_USART_ABORT_SEND, 0);
+    }
+    // batched output may have powered the UART down
+    if (!atomic_load_explicit(&tx_powered, memory_order_relaxed) &&
+        USARTdrv->PowerControl(ARM_POWER_FULL) == ARM_DRIVER_OK &&
+        uart_configure(tr_baudrate) == ARM_DRIVER_OK)
+    {
+        atomic_store_explicit(&tx_powered, true, memory_order_relaxed);
+    }
+}
+
+/*
+ * Send the committed records with polling, up to the first open reservation
+ * whose owner will not run again.
+ */
+static void tx_drain_polled(void)
+{
+    trace_ring_t *ring;
+    uint32_t hdr;
+    uint8_t *payload;
+
+    while ((ring = trace_tx_next(&tx_main, &hdr, &payload)) != NULL)
+    {
+        if (hdr & TRACE_REC_REF)
+        {
+            const trace_tx_ref_t ref = trace_tx_ref_get(payload);
+            tx_send_polled(ref.data, ref.len);
+        }
+        else
+        {
+            tx_send_polled(payload, hdr & TRACE_REC_LEN_Msk);
+        }
+        trace_ring_release(ring, hdr);
+    }
+}
+#endif
+
+int tracelib_send_polled(const char* str, uint32_t len)
+{
+    if (!initialized)
+    {
+        return 0;
+    }
+#if defined(TX_REMOTE_CORE)
+    // the drain core owns the UART, the channel ring is all this core has
+    return send_chunks(str, len);
+#else
+    if (!atomic_exchange_explicit(&tx_polled, true, memory_order_relaxed))
+    {
+        tx_abandon();
+    }
+    tx_drain_polled();
+    // the queued records were recorded when they were committed
+    trace_recorder_write(str, len);
+    tx_send_polled(str, len);
+    return ARM_DRIVER_OK;
+#endif
+}
+
+#if !defined(TX_REMOTE_CORE)
+/*
+ * Wait until everything queued has left the UART. The send complete event
+ * may come while the last characters are still in the transmit FIFO, so a
+ * FIFO worth of character times is waited on top of it.
+ */
+static void tx_drain(void)
+{
+    const uint32_t guard = GetSystemCoreClock() / tr_baudrate * 10 * 32;
+    const uint32_t start = alifs_profile_end(0);
+
+    tracelib_flush();
+    while (USARTdrv->GetStatus().tx_busy);
+    while (alifs_profile_end(start) < guard);
+}
+
+static void rx_discard(void)
+{
+    atomic_store_explicit(&rx_tail, atomic_load_explicit(&rx_head, memory_order_acquire),
+                          memory_order_release);
+}
+
+/*
+ * Wait for a handshake line from the host.
+ * @return 1 for the expected line, -1 for the rejection, 0 on timeout
+ */
+static int handshake_wait(const char *expected, const char *rejected, uint32_t timeout_ms)
+{
+    char line[40];
+    wait_timer_t timer = { .last = alifs_profile_end(0) };
+
+    while (!timed_out(&timer, timeout_ms))
+    {
+        if (tracelib_read_line(line, sizeof(line), 1) < 0)
+        {
+            continue;
+        }
+        if (strstr(line, expected))
+        {
+            return 1;
+        }
+        if (rejected && strstr(line, rejected))
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+#endif
+
+int tracelib_set_baudrate(uint32_t baudrate, uint32_t timeout_ms)
+{
+#if defined(TX_REMOTE_CORE)
+    (void)baudrate;
+    (void)timeout_ms;
+    return ARM_DRIVER_ERROR_UNSUPPORTED;
+#else
+    char line[40];
+    int32_t ret;
+    int len;
+
+    if (!initialized)
+    {
+        return ARM_DRIVER_ERROR;
+    }
+    if (baudrate == tr_baudrate)
+    {
+        return ARM_DRIVER_OK;
+    }
+
+    /* Ask at the current rate, the host answers before it switches */
+    rx_discard();
+    len = tracelib_snprintf(line, sizeof(line), "\n" TRACELIB_BAUD_REQUEST "%lu\n", (unsigned long)baudrate);
+    send_str(line, len);
+    switch (handshake_wait(TRACELIB_BAUD_ACCEPT, TRACELIB_BAUD_REJECT, timeout_ms))
+    {
+    case 0:
+        return ARM_DRIVER_ERROR_TIMEOUT;
+    case -1:
+        return ARM_DRIVER_ERROR_UNSUPPORTED;
+    default:
+        break;
+    }
+
+    const uint32_t previous = tr_baudrate;
+    tx_drain();
+    ret = uart_configure(baudrate);
+    if (ret == ARM_DRIVER_OK)
+    {
+        tr_baudrate = baudrate;
+        rx_discard();
+
+        /* Repeat the sync line until the host echoes it at the new rate */
+        wait_timer_t timer = { .last = alifs_profile_end(0) };
+        while (!timed_out(&timer, timeout_ms))
+        {
+            send_str(TRACELIB_BAUD_SYNC "\n", sizeof(TRACELIB_BAUD_SYNC));
+            if (handshake_wait(TRACELIB_BAUD_SYNC, NULL, 10) > 0)
+            {
+                return ARM_DRIVER_OK;
+            }
+        }
+        ret = ARM_DRIVER_ERROR_TIMEOUT;
+        tx_drain();
+    }
+
+    /* The host reverts on its own when it does not see the sync line */
+    (void)uart_configure(previous);
+    tr_baudrate = previous;
+    rx_discard();
+    return ret;
+#endif
+}
+
+uint32_t tracelib_get_baudrate(void)
+{
+#if defined(TX_REMOTE_CORE)
+    return 0;
+#else
+    return tr_baudrate;
+#endif
+}
+
+int tracelib_send_ref(const void *data, uint32_t len, tracelib_release_t release, void *ctx)
+{
+    if (!initialized)
+    {
+        return ARM_DRIVER_ERROR;
+    }
+
+    uint32_t rec;
+    uint8_t *dst = tx_reserve(sizeof(trace_tx_ref_t), &rec);
+    if (dst == NULL)
+    {
+        return ARM_DRIVER_ERROR_BUSY;
+    }
+
+    trace_tx_ref_put(dst, data, len, release, ctx);
+    trace_recorder_write(data, len);
+    trace_ring_commit(tx_main.ring, rec, sizeof(trace_tx_ref_t), sizeof(trace_tx_ref_t), TRACE_REC_REF);
+    tx_kick();
+    return ARM_DRIVER_OK;
+}
+
+void *tracelib_reserve(uint32_t len, tracelib_reservation_t *res)
+{
+    if (!initialized || len == 0 || len > TX_REC_MAX_LEN)
+    {
+        return NULL;
+    }
+
+    void *dst = tx_reserve(len, &res->rec);
+    res->size = dst ? len : 0;
+    return dst;
+}
+
+void tracelib_commit(const tracelib_reservation_t *res, uint32_t len)
+{
+    if (res->size == 0)
+    {
+        return;
+    }
+    if (len > res->size)
+    {
+        len = res->size;
+    }
+    tx_commit(res->rec, res->size, len);
+}
+
+void tracelib_set_sinks(uint32_t sinks)
+{
+#if defined(TX_REMOTE_CORE)
+    (void)sinks;
+#else
+    atomic_store_explicit(&tx_main.sinks, sinks, memory_order_relaxed);
+    if (initialized)
+    {
+        tx_pump();
+    }
+#endif
+}
+
+uint32_t tracelib_get_sinks(void)
+{
+#if defined(TX_REMOTE_CORE)
+    return TRACELIB_SINK_NULL;
+#else
+    return atomic_load_explicit(&tx_main.sinks, memory_order_relaxed);
+#endif
+}
+
+void tracelib_process(void)
+{
+    if (initialized)
+    {
+#if !defined(TX_REMOTE_CORE)
+        duty_update();
+        if (trace_tx_ready(&tx_main) && batch_due())
+        {
+            tx_pump();
+        }
+        tx_power_down();
+#endif
+    }
+}
+
+void tracelib_set_batch(uint32_t threshold, uint32_t timeout_ms)
+{
+#if defined(TX_REMOTE_CORE)
+    (void)threshold;
+    (void)timeout_ms;
+#else
+    batch_timeout_ms = timeout_ms;
+    batch_threshold = threshold;
+    if (initialized && threshold == 0)
+    {
+        /* Back to continuous output */
+        tx_pump();
+    }
+#endif
+}
+
+#if defined(TRACELIB_PENDSV_KICK) && !defined(A32)
+void PendSV_Handler(void)
+{
+    tracelib_process();
+}
+#endif
+
+void tracelib_flush(void)
+{
+    if (initialized)
+    {
+#if defined(TX_REMOTE_CORE)
+        /* Wait for the drain core to consume this core's records */
+        while (trace_ring_ready(tx_main.ring));
+#else
+        while (atomic_load_explicit(&tx_main.busy, memory_order_acquire) || trace_tx_ready(&tx_main))
+        {
+            tx_pump();
+            __WFE();
+        }
+#endif
+    }
+}
+
+uint32_t tracelib_timestamp(void)
+{
+    return trace_timestamp();
+}
+
+void tracelib_set_timestamp(tracelib_timestamp_t mode)
+{
+    ts_last = trace_timestamp();
+    ts_mode = mode;
+}
+
+void tracelib_get_stats(tracelib_stats_t *stats)
+{
+    stats->buffer_size = TRACELIB_TX_BUFFER_SIZE;
+    stats->used = 0;
+    stats->high_water = 0;
+    stats->dropped_bytes = 0;
+    stats->retries = 0;
+    if (tx_main.ring)
+    {
+        stats->used = atomic_load_explicit(&tx_main.ring->head, memory_order_relaxed) -
+                      atomic_load_explicit(&tx_main.ring->tail, memory_order_relaxed);
+        stats->high_water = atomic_load_explicit(&tx_main.ring->high_water, memory_order_relaxed);
+        stats->dropped_bytes = atomic_load_explicit(&tx_main.ring->dropped, memory_order_relaxed);
+        stats->retries = atomic_load_explicit(&tx_main.ring->retries, memory_order_relaxed);
+    }
+    stats->sent_bytes = atomic_load_explicit(&tx_main.sent, memory_order_relaxed);
+    stats->suppressed = atomic_load_explicit(&tr_suppressed, memory_order_relaxed);
+#if defined(TX_REMOTE_CORE)
+    stats->uart_power_ups = 0;
+    stats->uart_on_cycles = 0;
+    stats->uart_elapsed_cycles = 0;
+#else
+    duty_update();
+    stats->uart_power_ups = atomic_load_explicit(&tx_power_ups, memory_order_relaxed);
+    // not locked, another context may be sampling, read until stable
+    do {
+        stats->uart_on_cycles = duty_on;
+        stats->uart_elapsed_cycles = duty_elapsed;
+    } while (stats->uart_on_cycles != duty_on || stats->uart_elapsed_cycles != duty_elapsed);
+#endif
+#if defined(TRACELIB_MEASURE)
+    latency_get(&tr_tracef_latency, &stats->tracef_latency);
+    latency_get(&tr_send_latency, &stats->send_latency);
 #else
-    #error "Undefined CPU!"
+    memset(&stats->tracef_latency, 0, sizeof(stats->tracef_latency));
+    memset(&stats->send_latency, 0, sizeof(stats->send_latency));
 #endif
+    for (uint32_t i = 0; i < TRACELIB_CONTEXT_COUNT; i++)
+    {
+        stats->context_calls[i] = atomic_load_explicit(&tr_context_calls[i], memory_order_relaxed);
+    }
+}
 
-    tr_prefix = prefix;
-    if (tr_prefix)
+void tracelib_reset_stats(void)
+{
+    if (tx_main.ring)
     {
-        prefix_len = strlen(tr_prefix);
+        atomic_store_explicit(&tx_main.ring->high_water, 0, memory_order_relaxed);
+        atomic_store_explicit(&tx_main.ring->dropped, 0, memory_order_relaxed);
+        atomic_store_explicit(&tx_main.ring->retries, 0, memory_order_relaxed);
     }
-    else
+    atomic_store_explicit(&tx_main.sent, 0, memory_order_relaxed);
+    atomic_store_explicit(&tr_suppressed, 0, memory_order_relaxed);
+#if !defined(TX_REMOTE_CORE)
+    atomic_store_explicit(&tx_power_ups, 0, memory_order_relaxed);
+    atomic_store_explicit(&duty_reset, true, memory_order_relaxed);
+    duty_update();
+#endif
+#if defined(TRACELIB_MEASURE)
+    latency_reset(&tr_tracef_latency);
+    latency_reset(&tr_send_latency);
+#endif
+    for (uint32_t i = 0; i < TRACELIB_CONTEXT_COUNT; i++)
     {
-        prefix_len = 0;
+        atomic_store_explicit(&tr_context_calls[i], 0, memory_order_relaxed);
     }
+}
 
-    /* Initialize UART driver */
-    if (cb_event)
-    {
-        has_cb = true;
+#if defined(TRACELIB_DEFERRED_FORMAT)
+
+#define PUT_ARG(type, value)                            \
+    do {                                                \
+        type v_ = (value);                              \
+        if (len + sizeof(v_) > room) {                  \
+            return len;                                 \
+        }                                               \
+        memcpy(dst + len, &v_, sizeof(v_));             \
+        len += sizeof(v_);                              \
+    } while (0)
+
+/*
+ * Walk the conversion specifiers of format and store the raw argument words.
+ * Integers and pointers are stored in their native size, floating point values
+ * as double and strings as a length byte followed by the characters.
+ *
+ * @return number of bytes written to dst
+ */
+static uint32_t encode_args(uint8_t *dst, uint32_t room, const char *format, va_list args)
+{
+    uint32_t len = 0;
+
+    for (const char *p = format; *p; p++) {
+        if (*p != '%') {
+            continue;
+        }
+        p++;
+
+        while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0') {
+            p++;
+        }
+        if (*p == '*') {
+            PUT_ARG(int, va_arg(args, int));
+            p++;
+        }
+        while (*p >= '0' && *p <= '9') {
+            p++;
+        }
+        if (*p == '.') {
+            p++;
+            if (*p == '*') {
+                PUT_ARG(int, va_arg(args, int));
+                p++;
+            }
+            while (*p >= '0' && *p <= '9') {
+                p++;
+            }
+        }
+
+        int longs = 0;
+        bool long_double = false;
+        for (;; p++) {
+            if (*p == 'l') {
+                longs++;
+            } else if (*p == 'j') {
+                longs = 2;
+            } else if (*p == 'L') {
+                long_double = true;
+            } else if (*p != 'h' && *p != 'z' && *p != 't') {
+                break;
+            }
+        }
+
+        switch (*p) {
+        case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c':
+            if (longs >= 2) {
+                PUT_ARG(long long, va_arg(args, long long));
+            } else if (longs == 1) {
+                PUT_ARG(long, va_arg(args, long));
+            } else {
+                PUT_ARG(int, va_arg(args, int));
+            }
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            if (long_double) {
+                PUT_ARG(double, (double)va_arg(args, long double));
+            } else {
+                PUT_ARG(double, va_arg(args, double));
+            }
+            break;
+        case 'p':
+            PUT_ARG(uintptr_t, (uintptr_t)va_arg(args, void *));
+            break;
+        case 's': {
+            const char *str = va_arg(args, const char *);
+            uint32_t str_len = str ? strlen(str) : 0;
+            if (str_len > UINT8_MAX) {
+                str_len = UINT8_MAX;
+            }
+            if (len + 1 + str_len > room) {
+                return len;
+            }
+            dst[len++] = (uint8_t)str_len;
+            memcpy(dst + len, str, str_len);
+            len += str_len;
+            break;
+        }
+        case 'n':
+            (void)va_arg(args, int *);
+            break;
+        case '\0':
+            return len;
+        default:
+            break;
+        }
     }
-    ret = USARTdrv->Initialize(cb_event);
-    if (ret != ARM_DRIVER_OK)
+    return len;
+}
+
+#undef PUT_ARG
+
+static void trace_message(const char * format, va_list args)
+{
+    uint8_t record[MAX_TRACE_LEN];
+
+    /* Record header, see TRACELIB_DEFERRED_FORMAT in uart_tracelib.h */
+    const uint32_t fmt_id = (uint32_t)(uintptr_t)format;
+    const uint32_t timestamp = trace_timestamp();
+    record[0] = TRACELIB_BIN_RECORD_MARKER;
+    memcpy(record + 3, &fmt_id, sizeof(fmt_id));
+    memcpy(record + 7, &timestamp, sizeof(timestamp));
+
+    uint32_t len = TRACELIB_BIN_RECORD_HDR_SIZE;
+    len += encode_args(record + len, sizeof(record) - len, format, args);
+
+    const uint16_t body_len = len - 3;
+    memcpy(record + 1, &body_len, sizeof(body_len));
+    tx_write(record, len);
+}
+
+#else
+
+#define TIMESTAMP_MAX_LEN 14
+
+/*
+ * Write "[timestamp] " to buf, absolute timestamps are padded to a fixed width.
+ *
+ * @return number of characters written
+ */
+static uint32_t format_timestamp(char *buf)
+{
+    const uint32_t now = trace_timestamp();
+    uint32_t value = now;
+    uint32_t width = 10;
+    char digits[10];
+    uint32_t len = 0;
+
+    buf[len++] = '[';
+    if (ts_mode == TRACELIB_TIMESTAMP_DELTA)
     {
-        return ret;
+        value = now - atomic_exchange_explicit(&ts_last, now, memory_order_relaxed);
+        buf[len++] = '+';
+        width = 0;
     }
 
-    /* Power up UART peripheral */
-    ret = USARTdrv->PowerControl(ARM_POWER_FULL);
-    if (ret != ARM_DRIVER_OK)
+    const uint32_t n = trace_encode_dec32(digits, value);
+    while (width > n)
     {
-        return ret;
+        buf[len++] = ' ';
+        width--;
     }
+    memcpy(buf + len, digits, n);
+    len += n;
+    buf[len++] = ']';
+    buf[len++] = ' ';
+    return len;
+}
 
-    ret =  USARTdrv->Control(ARM_USART_MODE_ASYNCHRONOUS |
-                             ARM_USART_DATA_BITS_8       |
-                             ARM_USART_PARITY_NONE       |
-                             ARM_USART_STOP_BITS_1       |
-                             ARM_USART_FLOW_CONTROL_NONE, TRACELIB_UART_BAUDRATE);
-    if (ret != ARM_DRIVER_OK)
+/*
+ * Format the line on the stack and queue it with its exact length. A fault
+ * while formatting (e.g. a bad %s pointer) then leaves no reservation behind
+ * that would block the transmit ring.
+ */
+static void trace_message(const char * format, va_list args)
+{
+    char buffer[MAX_TRACE_LEN];
+
+    int len = prefix_len;
+    if (prefix_len) {
+        memcpy(buffer, tr_prefix, prefix_len);
+    }
+    if (ts_mode != TRACELIB_TIMESTAMP_NONE && len + TIMESTAMP_MAX_LEN < MAX_TRACE_LEN) {
+        len += format_timestamp(buffer + len);
+    }
+#if defined(TRACELIB_LIBC_FORMAT)
+    int msg_len = vsnprintf(buffer + len, MAX_TRACE_LEN - len, format, args);
+#else
+    int msg_len = tracelib_vsnprintf(buffer + len, MAX_TRACE_LEN - len, format, args);
+#endif
+    if (msg_len < 0)
     {
-        return ret;
+        msg_len = 0;
     }
-
-    /* Transmitter line */
-    ret =  USARTdrv->Control(ARM_USART_CONTROL_TX, 1);
-    if (ret != ARM_DRIVER_OK)
+    len += msg_len;
+    if (len >= MAX_TRACE_LEN)
     {
-        return ret;
+        len = MAX_TRACE_LEN - 1;
     }
+    tx_write(buffer, len);
+}
 
-    /* Receiver line */
-    ret =  USARTdrv->Control(ARM_USART_CONTROL_RX, 1);
-    if (ret != ARM_DRIVER_OK)
+#endif // TRACELIB_DEFERRED_FORMAT
+
+/*
+ * Rate limiting. Every call site (format string) may trace burst messages per
+ * window, the rest are counted and reported with the next message that gets
+ * through. Call sites share a direct mapped table indexed by the format
+ * pointer, a colliding site takes the slot over and starts from scratch.
+ * The state is not locked, concurrent calls from the same site can miscount.
+ */
+#ifndef TRACELIB_LIMIT_BURST
+#define TRACELIB_LIMIT_BURST 0
+#endif
+
+#ifndef TRACELIB_LIMIT_WINDOW_MS
+#define TRACELIB_LIMIT_WINDOW_MS 1000
+#endif
+
+#ifndef TRACELIB_LIMIT_SLOTS
+#define TRACELIB_LIMIT_SLOTS 32
+#endif
+
+#if (TRACELIB_LIMIT_SLOTS & (TRACELIB_LIMIT_SLOTS - 1)) != 0
+#error "TRACELIB_LIMIT_SLOTS must be a power of two"
+#endif
+
+static tracelib_limit_t limit_slots[TRACELIB_LIMIT_SLOTS];
+static uint32_t limit_burst = TRACELIB_LIMIT_BURST;
+static uint32_t limit_window_ms = TRACELIB_LIMIT_WINDOW_MS;
+
+static const char limit_repeat_format[] = "last message repeated %lu times\n";
+
+static uint32_t limit_window_cycles(uint32_t window_ms)
+{
+    const uint64_t cycles = (uint64_t)window_ms * (GetSystemCoreClock() / 1000);
+    return cycles > UINT32_MAX ? UINT32_MAX : (uint32_t)cycles;
+}
+
+/*
+ * @return false if the message must be suppressed, otherwise the number of
+ *         messages suppressed since the last one is returned in repeats
+ */
+static bool limit_pass(tracelib_limit_t *limit, uint32_t burst, uint32_t window_ms, uint32_t *repeats)
+{
+    const uint32_t now = alifs_profile_end(0);
+
+    if (now - limit->window_start >= limit_window_cycles(window_ms)) {
+        limit->window_start = now;
+        limit->count = 0;
+    }
+    if (limit->count >= burst) {
+        limit->suppressed++;
+        atomic_fetch_add_explicit(&tr_suppressed, 1, memory_order_relaxed);
+        return false;
+    }
+    limit->count++;
+    *repeats = limit->suppressed;
+    limit->suppressed = 0;
+    return true;
+}
+
+static void trace_emit(const char * format, va_list args)
+{
+    /* Count the calling context, a nonzero depth means another tracef was preempted */
+    tracelib_context_t ctx = in_interrupt() ? TRACELIB_CONTEXT_ISR : TRACELIB_CONTEXT_THREAD;
+    if (atomic_fetch_add_explicit(&tr_depth, 1, memory_order_relaxed) != 0)
     {
-        return ret;
+        ctx = TRACELIB_CONTEXT_NESTED;
     }
+    atomic_fetch_add_explicit(&tr_context_calls[ctx], 1, memory_order_relaxed);
 
-    initialized = true;
-    return ret;
+#if defined(TRACELIB_MEASURE)
+    const uint32_t start = alifs_profile_end(0);
+#endif
+    trace_message(format, args);
+#if defined(TRACELIB_MEASURE)
+    latency_update(&tr_tracef_latency, alifs_profile_end(start));
+#endif
+
+    atomic_fetch_sub_explicit(&tr_depth, 1, memory_order_relaxed);
 }
 
-int tracelib_uninit()
+static void trace_emitf(const char * format, ...)
 {
-    int32_t ret = 0;
-    if (initialized)
-    {
-        initialized = false;
+    va_list args;
+    va_start(args, format);
+    trace_emit(format, args);
+    va_end(args);
+}
 
-        /* Power down UART peripheral */
-        ret = USARTdrv->PowerControl(ARM_POWER_OFF);
-        if (ret != ARM_DRIVER_OK)
-        {
-            return ret;
-        }
+static void trace_limited(tracelib_limit_t *limit, uint32_t burst, uint32_t window_ms,
+                          const char * format, va_list args)
+{
+    uint32_t repeats;
 
-        ret = USARTdrv->Uninitialize();
-        if (ret != ARM_DRIVER_OK)
-        {
-            return ret;
-        }
+    if (!limit_pass(limit, burst, window_ms, &repeats))
+    {
+        return;
+    }
+    trace_emit(format, args);
+    if (repeats)
+    {
+        trace_emitf(limit_repeat_format, (unsigned long)repeats);
     }
-    return ret;
 }
 
-int receive_str(char* str, uint32_t len)
+void vtracef(const char * format, va_list args)
 {
-    int ret = 0;
     if (initialized)
     {
-        ret = USARTdrv->Receive(str, len);
-        if (ret != ARM_DRIVER_OK)
+        const uint32_t burst = limit_burst;
+        if (burst == 0)
         {
-            return ret;
+            trace_emit(format, args);
+            return;
         }
-        if (has_cb == false)
+
+        const uintptr_t key = (uintptr_t)format;
+        tracelib_limit_t *limit = &limit_slots[((key >> 2) ^ (key >> 9)) & (TRACELIB_LIMIT_SLOTS - 1)];
+        if (limit->format != format)
         {
-            while (USARTdrv->GetRxCount() != len);
+            *limit = (tracelib_limit_t){ .format = format, .window_start = alifs_profile_end(0) };
         }
-    } else {
-        ret = -1;
+        trace_limited(limit, burst, limit_window_ms, format, args);
     }
-    return ret;
 }
 
-int send_str(const char* str, uint32_t len)
+void tracef_limited(tracelib_limit_t *limit, uint32_t burst, uint32_t window_ms, const char * format, ...)
 {
-    int ret = 0;
-
     if (initialized)
     {
-        uart_event = 0;
-        ret = USARTdrv->Send(str, len);
-        if (ret != ARM_DRIVER_OK)
-        {
-            return ret;
-        }
-
-        while (USARTdrv->GetTxCount() != len) __WFE();
+        va_list args;
+        va_start(args, format);
+        trace_limited(limit, burst, window_ms, format, args);
+        va_end(args);
     }
-    return ret;
 }
 
-void vtracef(const char * format, va_list args)
+void tracef_unlimited(const char * format, ...)
 {
     if (initialized)
     {
-        static char buffer[MAX_TRACE_LEN];
-
-        if (prefix_len) {
-            memcpy(buffer, tr_prefix, prefix_len);
-        }
-        vsnprintf(buffer + prefix_len, sizeof(buffer) - prefix_len, format, args);
-        send_str(buffer, strlen(buffer));
+        va_list args;
+        va_start(args, format);
+        trace_emit(format, args);
+        va_end(args);
     }
 }
 
+void tracelib_set_rate_limit(uint32_t burst, uint32_t window_ms)
+{
+    limit_window_ms = window_ms;
+    limit_burst = burst;
+}
+
 void tracef(const char * format, ...)
 {
     va_list args;
@@ -236,6 +1875,51 @@ void tracef(const char * format, ...)
     va_end(args);
 }
 
+#define DUMP_BYTES_PER_LINE 16
+
+void tracelib_dump(const char *label, const void *data, uint32_t len)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    const uint32_t offset_digits = len > 0x10000 ? 8 : 4;
+    /* offset, ':', 4 groups of ' ' and 8 digits, 2 spaces, ASCII, zero */
+    char line[8 + 1 + 4 * 9 + 2 + DUMP_BYTES_PER_LINE + 1];
+
+    if (!initialized)
+    {
+        return;
+    }
+
+    for (uint32_t offset = 0; offset < len; offset += DUMP_BYTES_PER_LINE)
+    {
+        const uint32_t count = len - offset < DUMP_BYTES_PER_LINE ? len - offset : DUMP_BYTES_PER_LINE;
+        char hex[2 * DUMP_BYTES_PER_LINE];
+        char offset_hex[8];
+        uint32_t n = 0;
+
+        trace_encode_hex32(offset_hex, &offset, 1);
+        memcpy(line, offset_hex + 8 - offset_digits, offset_digits);
+        n += offset_digits;
+        line[n++] = ':';
+
+        trace_encode_hex8(hex, bytes + offset, count);
+        for (uint32_t i = 0; i < 2 * DUMP_BYTES_PER_LINE; i += 8)
+        {
+            line[n++] = ' ';
+            for (uint32_t j = i; j < i + 8; j++)
+            {
+                line[n++] = j < 2 * count ? hex[j] : ' ';
+            }
+        }
+        line[n++] = ' ';
+        line[n++] = ' ';
+        trace_encode_ascii(line + n, bytes + offset, count);
+        n += count;
+        line[n] = '\0';
+
+        trace_emitf("%s %s\n", label, line);
+    }
+}
+
 #else
 
 int tracelib_init(const char * prefix, ARM_USART_SignalEvent_t cb_event)
@@ -257,6 +1941,28 @@ int receive_str(char* str, uint32_t len)
     return 0;
 }
 
+int tracelib_read(char* buf, uint32_t len, uint32_t timeout_ms)
+{
+    (void)buf;
+    (void)len;
+    (void)timeout_ms;
+    return 0;
+}
+
+int tracelib_read_line(char* buf, uint32_t size, uint32_t timeout_ms)
+{
+    (void)buf;
+    (void)size;
+    (void)timeout_ms;
+    return ARM_DRIVER_ERROR_TIMEOUT;
+}
+
+void tracelib_get_rx_stats(uint32_t *available, uint32_t *overflow)
+{
+    *available = 0;
+    *overflow = 0;
+}
+
 int send_str(const char* str, uint32_t len)
 {
     (void)str;
@@ -264,6 +1970,100 @@ int send_str(const char* str, uint32_t len)
     return 0;
 }
 
+int tracelib_write(const char* str, uint32_t len, uint32_t timeout_ms)
+{
+    (void)str;
+    (void)len;
+    (void)timeout_ms;
+    return 0;
+}
+
+int tracelib_send_polled(const char* str, uint32_t len)
+{
+    (void)str;
+    (void)len;
+    return 0;
+}
+
+int tracelib_set_baudrate(uint32_t baudrate, uint32_t timeout_ms)
+{
+    (void)baudrate;
+    (void)timeout_ms;
+    return ARM_DRIVER_ERROR_UNSUPPORTED;
+}
+
+uint32_t tracelib_get_baudrate(void)
+{
+    return 0;
+}
+
+int tracelib_send_ref(const void *data, uint32_t len, tracelib_release_t release, void *ctx)
+{
+    (void)data;
+    (void)len;
+    if (release)
+    {
+        release(ctx);
+    }
+    return 0;
+}
+
+void *tracelib_reserve(uint32_t len, tracelib_reservation_t *res)
+{
+    (void)len;
+    res->size = 0;
+    return NULL;
+}
+
+void tracelib_commit(const tracelib_reservation_t *res, uint32_t len)
+{
+    (void)res;
+    (void)len;
+}
+
+void tracelib_set_sinks(uint32_t sinks)
+{
+    (void)sinks;
+}
+
+uint32_t tracelib_get_sinks(void)
+{
+    return TRACELIB_SINK_NULL;
+}
+
+void tracelib_process(void)
+{
+}
+
+void tracelib_set_batch(uint32_t threshold, uint32_t timeout_ms)
+{
+    (void)threshold;
+    (void)timeout_ms;
+}
+
+void tracelib_flush(void)
+{
+}
+
+uint32_t tracelib_timestamp(void)
+{
+    return 0;
+}
+
+void tracelib_set_timestamp(tracelib_timestamp_t mode)
+{
+    (void)mode;
+}
+
+void tracelib_get_stats(tracelib_stats_t *stats)
+{
+    *stats = (tracelib_stats_t){ 0 };
+}
+
+void tracelib_reset_stats(void)
+{
+}
+
 void vtracef(const char * format, va_list args)
 {
     (void)format;
@@ -275,6 +2075,32 @@ void tracef(const char * format, ...)
     (void)format;
 }
 
+void tracef_limited(tracelib_limit_t *limit, uint32_t burst, uint32_t window_ms, const char * format, ...)
+{
+    (void)limit;
+    (void)burst;
+    (void)window_ms;
+    (void)format;
+}
+
+void tracef_unlimited(const char * format, ...)
+{
+    (void)format;
+}
+
+void tracelib_set_rate_limit(uint32_t burst, uint32_t window_ms)
+{
+    (void)burst;
+    (void)window_ms;
+}
+
+void tracelib_dump(const char *label, const void *data, uint32_t len)
+{
+    (void)label;
+    (void)data;
+    (void)len;
+}
+
 #endif // DISABLE_UART_TRACE
 
 /************************ (C) COPYRIGHT ALIF SEMICONDUCTOR *****END OF FILE****/
@@ -12,6 +12,8 @@
 #define UART_TRACELIB_H_
 
 #include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include "Driver_USART.h"
 
@@ -19,6 +21,79 @@
 extern "C" {
 #endif
 
+/**
+ * @brief Execution context of a tracef call.
+ */
+typedef enum {
+    TRACELIB_CONTEXT_THREAD,    /* thread mode */
+    TRACELIB_CONTEXT_ISR,       /* interrupt handler */
+    TRACELIB_CONTEXT_NESTED,    /* preempted another tracef call that was in progress */
+    TRACELIB_CONTEXT_COUNT
+} tracelib_context_t;
+
+/**
+ * @brief Cycles spent in a call, only collected when built with TRACELIB_MEASURE.
+ */
+typedef struct {
+    uint32_t calls;
+    uint32_t total_cycles;  /* wraps after 2^32 cycles spent in the call */
+    uint32_t max_cycles;
+} tracelib_latency_t;
+
+/**
+ * @brief Transmit buffer statistics.
+ */
+typedef struct {
+    uint32_t buffer_size;   /* size of the transmit ring in bytes */
+    uint32_t used;          /* bytes currently queued (including record headers) */
+    uint32_t high_water;    /* peak number of bytes queued */
+    uint32_t dropped_bytes; /* payload bytes dropped because the ring was full */
+    uint32_t sent_bytes;    /* bytes transmitted or written to the sinks */
+    uint32_t retries;       /* ring reservations retried due to contention between producers */
+    uint32_t suppressed;    /* tracef calls dropped by rate limiting */
+    uint32_t uart_power_ups;        /* bursts that powered the UART up, see tracelib_set_batch */
+    uint64_t uart_on_cycles;        /* cycles the UART was powered, duty cycle is */
+    uint64_t uart_elapsed_cycles;   /* uart_on_cycles / uart_elapsed_cycles */
+    uint32_t context_calls[TRACELIB_CONTEXT_COUNT]; /* tracef calls per execution context */
+    tracelib_latency_t tracef_latency;              /* tracef and vtracef */
+    tracelib_latency_t send_latency;                /* send_str, includes the printf retarget path */
+} tracelib_stats_t;
+
+/**
+ * @brief Transmit buffer reservation made with tracelib_reserve.
+ */
+typedef struct {
+    uint32_t rec;           /* ring position of the record */
+    uint32_t size;          /* reserved payload bytes, 0 if the reservation failed */
+} tracelib_reservation_t;
+
+/**
+ * @brief Called when a buffer queued with tracelib_send_ref is no longer used.
+ */
+typedef void (*tracelib_release_t)(void *ctx);
+
+/**
+ * @brief Timestamp added to every trace line.
+ */
+typedef enum {
+    TRACELIB_TIMESTAMP_NONE,        /* no timestamp */
+    TRACELIB_TIMESTAMP_ABSOLUTE,    /* "[   1234567] " raw counter value */
+    TRACELIB_TIMESTAMP_DELTA        /* "[+1234] " counts since the previous trace line */
+} tracelib_timestamp_t;
+
+/*
+ * Shared multi-core log channel
+ *
+ * Define TRACELIB_CHANNEL_ADDR (shared, non-cacheable SRAM, same address on all
+ * cores) and a unique TRACELIB_CHANNEL_CORE_ID per core to route the output of
+ * every core into one UART. Exactly one core is built with TRACELIB_CHANNEL_DRAIN,
+ * it owns the UART and merges the records of all cores in timestamp order.
+ * The other cores only write into their ring in shared memory and never touch a
+ * UART driver, use a per core prefix to tell them apart in the output. Records
+ * of other cores are picked up when the drain core transmits or calls
+ * tracelib_process, so call it periodically there.
+ */
+
 /**
  * @brief Initializes the trace lib.
  *
@@ -33,28 +108,626 @@ int tracelib_init(const char * prefix, ARM_USART_SignalEvent_t cb_event);
  */
 int tracelib_uninit();
 
+/*
+ * When TRACELIB_DEFERRED_FORMAT is defined tracef does not format the message
+ * on target. Every call emits a binary record instead which is turned back into
+ * text on the host by logging/analyser/decode_trace.py using the ELF file:
+ *
+ *   u8  TRACELIB_BIN_RECORD_MARKER
+ *   u16 length of the rest of the record
+ *   u32 address of the format string
+ *   u32 timestamp in CPU cycles
+ *   ... raw arguments in format string order, little endian, unaligned:
+ *       integers and pointers in their native size, floating point as double,
+ *       strings as a length byte followed by the characters
+ *
+ * The prefix is not sent in this mode and format strings must be located in
+ * memory that is part of the ELF image.
+ */
+#define TRACELIB_BIN_RECORD_MARKER   0xA5
+#define TRACELIB_BIN_RECORD_HDR_SIZE 11
+
 /**
  * @brief write trace to UART
+ *
+ * Safe to call from threads, ISRs and nested ISRs. Every call formats up to 255
+ * characters on its stack and queues the line with its length. It never
+ * blocks, messages are dropped when the ring has no room for them.
  */
 void tracef(const char * format, ...);
 void vtracef(const char * format, va_list args);
 
+/**
+ * @brief snprintf replacement used by tracef, see trace_format.c
+ *
+ * Does not allocate, lock or use the C library, so it can be called from any
+ * context. Covers the integer, string, pointer and float conversions with up
+ * to 9 fractional digits. Define TRACELIB_LIBC_FORMAT to let tracef use
+ * vsnprintf of the C library instead.
+ *
+ * @return length of the complete output like snprintf, even when truncated
+ */
+int tracelib_snprintf(char *buf, size_t size, const char *format, ...);
+int tracelib_vsnprintf(char *buf, size_t size, const char *format, va_list args);
+
+/**
+ * @brief Receives the output of tracelib_vformat one piece at a time.
+ */
+typedef void (*tracelib_format_write_t)(const char *data, size_t len, void *ctx);
+
+/**
+ * @brief Format output of any length through a small buffer.
+ *
+ * Like tracelib_vsnprintf, but every time buf is full its content is handed
+ * to write and formatting continues from the start of buf. Nothing is lost.
+ *
+ * @param size size of buf, at least 2. Pieces are at most size - 1 bytes
+ * @return length of the complete output
+ */
+int tracelib_vformat(tracelib_format_write_t write, void *ctx, char *buf, size_t size,
+                     const char *format, va_list args);
+
+/**
+ * @brief Trace a hex dump of data, 16 bytes per line:
+ *
+ *   label 0010: 00112233 44556677 8899AABB CCDDEEFF  ..."3DUfw.......
+ *
+ * Bytes are shown in memory order. Offsets have 8 digits when len is above
+ * 64 KiB. The lines are not rate limited.
+ */
+void tracelib_dump(const char *label, const void *data, uint32_t len);
+
+/**
+ * @brief Rate limit state of a call site.
+ */
+typedef struct {
+    const char *format;     /* call site owning a slot of the global table */
+    uint32_t window_start;  /* cycle count at the start of the current window */
+    uint32_t count;         /* messages traced in the current window */
+    uint32_t suppressed;    /* messages dropped since the last traced one */
+} tracelib_limit_t;
+
+/**
+ * @brief Limit the rate of all tracef calls.
+ *
+ * Each format string may trace burst messages per window_ms, further ones
+ * are dropped and reported as "last message repeated N times" after the next
+ * message of the same format that gets through. The defaults are
+ * TRACELIB_LIMIT_BURST (0, no limit) and TRACELIB_LIMIT_WINDOW_MS.
+ *
+ * @param burst     messages per window, 0 disables the limit
+ * @param window_ms length of the window
+ */
+void tracelib_set_rate_limit(uint32_t burst, uint32_t window_ms);
+
+/**
+ * @brief tracef with a rate limit of its own, see TRACE_LIMITED.
+ */
+void tracef_limited(tracelib_limit_t *limit, uint32_t burst, uint32_t window_ms, const char * format, ...);
+
+/**
+ * @brief tracef that bypasses the rate limit, for output asked for by the
+ *        user such as the replies of the shell.
+ */
+void tracef_unlimited(const char * format, ...);
+
+/**
+ * @brief Trace at most burst messages per window_ms from this call site.
+ *
+ * Overrides the global limit for the call site, for example
+ * TRACE_LIMITED(1, 1000, "sensor error %d\n", err);
+ */
+#define TRACE_LIMITED(burst, window_ms, ...)                                    \
+    do {                                                                        \
+        static tracelib_limit_t tracelib_site_limit_;                           \
+        tracef_limited(&tracelib_site_limit_, (burst), (window_ms), __VA_ARGS__); \
+    } while (0)
+
+/*
+ * Leveled trace macros.
+ *
+ * TRACE_LEVEL_MAX sets the compile-time threshold for the whole build and
+ * TRACE_MODULE_LEVEL the threshold for one source file. TRACE_MODULE_ID
+ * (0 .. TRACELIB_MAX_MODULES - 1) selects the runtime threshold slot of the
+ * file. Define the module macros before including this header:
+ *
+ *   #define TRACE_MODULE_ID    3
+ *   #define TRACE_MODULE_LEVEL TRACE_LEVEL_DEBUG
+ *   #include "uart_tracelib.h"
+ *
+ * Calls above the compile-time threshold are removed by the preprocessor so
+ * neither code nor the format string end up in the image. The remaining calls
+ * are filtered at runtime with tracelib_set_level at the cost of one byte load
+ * and one compare.
+ */
+#define TRACE_LEVEL_NONE    0
+#define TRACE_LEVEL_ERROR   1
+#define TRACE_LEVEL_WARN    2
+#define TRACE_LEVEL_INFO    3
+#define TRACE_LEVEL_DEBUG   4
+#define TRACE_LEVEL_VERBOSE 5
+
+#define TRACELIB_MAX_MODULES 32
+
+#ifndef TRACE_LEVEL_MAX
+#define TRACE_LEVEL_MAX TRACE_LEVEL_VERBOSE
+#endif
+
+#ifndef TRACE_MODULE_LEVEL
+#define TRACE_MODULE_LEVEL TRACE_LEVEL_MAX
+#endif
+
+#ifndef TRACE_MODULE_ID
+#define TRACE_MODULE_ID 0
+#endif
+
+#if defined(DISABLE_UART_TRACE) || TRACE_MODULE_LEVEL > TRACE_LEVEL_MAX
+#undef TRACE_MODULE_LEVEL
+#if defined(DISABLE_UART_TRACE)
+#define TRACE_MODULE_LEVEL TRACE_LEVEL_NONE
+#else
+#define TRACE_MODULE_LEVEL TRACE_LEVEL_MAX
+#endif
+#endif
+
+/* Runtime threshold per module, stored as distance from TRACE_LEVEL_VERBOSE so zero means everything is on */
+extern uint8_t tracelib_module_quiet[TRACELIB_MAX_MODULES];
+
+#define TRACE_ENABLED(level) \
+    ((level) + tracelib_module_quiet[TRACE_MODULE_ID] <= TRACE_LEVEL_VERBOSE)
+
+#define TRACE_AT(level, ...)                \
+    do {                                    \
+        if (TRACE_ENABLED(level)) {         \
+            tracef(__VA_ARGS__);            \
+        }                                   \
+    } while (0)
+
+#if TRACE_MODULE_LEVEL >= TRACE_LEVEL_ERROR
+#define TRACE_ERROR(...) TRACE_AT(TRACE_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define TRACE_ERROR(...) do { } while (0)
+#endif
+
+#if TRACE_MODULE_LEVEL >= TRACE_LEVEL_WARN
+#define TRACE_WARN(...) TRACE_AT(TRACE_LEVEL_WARN, __VA_ARGS__)
+#else
+#define TRACE_WARN(...) do { } while (0)
+#endif
+
+#if TRACE_MODULE_LEVEL >= TRACE_LEVEL_INFO
+#define TRACE_INFO(...) TRACE_AT(TRACE_LEVEL_INFO, __VA_ARGS__)
+#else
+#define TRACE_INFO(...) do { } while (0)
+#endif
+
+#if TRACE_MODULE_LEVEL >= TRACE_LEVEL_DEBUG
+#define TRACE_DEBUG(...) TRACE_AT(TRACE_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define TRACE_DEBUG(...) do { } while (0)
+#endif
+
+#if TRACE_MODULE_LEVEL >= TRACE_LEVEL_VERBOSE
+#define TRACE_VERBOSE(...) TRACE_AT(TRACE_LEVEL_VERBOSE, __VA_ARGS__)
+#else
+#define TRACE_VERBOSE(...) do { } while (0)
+#endif
+
+/**
+ * @brief Set the runtime trace level of a module.
+ *
+ * @param module module id, TRACELIB_MAX_MODULES sets all modules
+ * @param level  highest level that is traced
+ */
+void tracelib_set_level(uint32_t module, uint32_t level);
+
+/**
+ * @brief Get the runtime trace level of a module.
+ */
+uint32_t tracelib_get_level(uint32_t module);
+
+/* Size of the receive ring, a power of two */
+#ifndef TRACELIB_RX_BUFFER_SIZE
+#define TRACELIB_RX_BUFFER_SIZE 256
+#endif
+
 /**
  * @brief Receive string from UART.
  *
+ * The UART receives into a buffer in the background all the time, this takes
+ * len bytes from it. Without a callback the call waits (WFE) until len bytes
+ * have been received. With a callback it returns immediately and the callback
+ * gets ARM_USART_EVENT_RECEIVE_COMPLETE once str has been filled.
+ *
  * @param str string buffer for received data
  * @param len maximum length of the string
  */
 int receive_str(char* str, uint32_t len);
 
+#define TRACELIB_WAIT_FOREVER UINT32_MAX
+
+/**
+ * @brief Read the bytes received so far.
+ *
+ * @param buf        buffer for received data
+ * @param len        size of buf
+ * @param timeout_ms time to wait for the first byte, 0 returns immediately,
+ *                   TRACELIB_WAIT_FOREVER waits until something is received
+ * @return number of bytes read, 0 on timeout
+ */
+int tracelib_read(char* buf, uint32_t len, uint32_t timeout_ms);
+
+/**
+ * @brief Read one line terminated by '\n'.
+ *
+ * The line is only consumed once it has been received completely, or when it
+ * does not fit into buf or the receive ring, in which case the first size - 1
+ * or TRACELIB_RX_BUFFER_SIZE bytes are returned and the rest of the line
+ * follows with the next call.
+ * The terminator (and a preceding '\r') is removed and buf is NUL terminated.
+ *
+ * @param buf        buffer for the line
+ * @param size       size of buf
+ * @param timeout_ms see tracelib_read
+ * @return length of the line or ARM_DRIVER_ERROR_TIMEOUT
+ */
+int tracelib_read_line(char* buf, uint32_t size, uint32_t timeout_ms);
+
+/**
+ * @brief Get receive buffer statistics.
+ *
+ * @param available bytes waiting to be read
+ * @param overflow  bytes lost because the receive buffer was full
+ */
+void tracelib_get_rx_stats(uint32_t *available, uint32_t *overflow);
+
+/*
+ * Baud rate handshake lines, keep in sync with logging/analyser/trace_capture.py.
+ * The target sends TRACELIB_BAUD_REQUEST followed by the rate at the current
+ * rate, the host answers TRACELIB_BAUD_ACCEPT (or TRACELIB_BAUD_REJECT) and
+ * both switch. The target then repeats TRACELIB_BAUD_SYNC at the new rate
+ * until the host echoes it back, otherwise both return to the previous rate.
+ */
+#define TRACELIB_BAUD_REQUEST  "@tracelib baud "
+#define TRACELIB_BAUD_ACCEPT   "@tracelib baud ok"
+#define TRACELIB_BAUD_REJECT   "@tracelib baud no"
+#define TRACELIB_BAUD_SYNC     "@tracelib sync"
+
+/**
+ * @brief Switch the UART to another baud rate after a handshake with the host.
+ *
+ * Queued output is sent at the current rate before switching. Define
+ * TRACELIB_UART_FAST_BAUDRATE to do this from tracelib_init.
+ *
+ * @param baudrate   new baud rate
+ * @param timeout_ms time to wait for each host answer
+ * @return ARM_DRIVER_OK when switched, ARM_DRIVER_ERROR_TIMEOUT when the host
+ *         did not answer or ARM_DRIVER_ERROR_UNSUPPORTED when it refused the
+ *         rate. The previous rate is kept on failure.
+ */
+int tracelib_set_baudrate(uint32_t baudrate, uint32_t timeout_ms);
+
+/**
+ * @brief Get the current UART baud rate.
+ */
+uint32_t tracelib_get_baudrate(void);
+
 /**
  * @brief Send string to UART, no prefix is prepended.
  *
+ * The string is copied into the transmit ring buffer and sent in the
+ * background, the call does not wait for the transmission.
+ *
  * @param str string to send over UART
  * @param len length of the string
+ * @return ARM_DRIVER_ERROR_BUSY if the ring buffer had no room for the string
  */
 int send_str(const char* str, uint32_t len);
 
+/**
+ * @brief Send string to UART, waiting for room in the transmit ring.
+ *
+ * Like send_str, but while the ring is full the call waits up to timeout_ms
+ * for the transmission to make room. Only threads with interrupts enabled
+ * wait, ISRs and code with interrupts disabled return at once as with a
+ * timeout of 0. Used for printf by the retarget layer.
+ *
+ * @param str        string to send over UART
+ * @param len        length of the string
+ * @param timeout_ms time to wait for room, TRACELIB_WAIT_FOREVER to never give up
+ * @return number of bytes queued, the rest is dropped and accounted in tracelib_get_stats
+ */
+int tracelib_write(const char* str, uint32_t len, uint32_t timeout_ms);
+
+/**
+ * @brief Send string to UART synchronously, for fault handlers.
+ *
+ * The first call gives up the interrupt driven transmission for good, the
+ * ongoing transmission is aborted. Every call sends the records committed to
+ * the transmit ring so far and then str, all with polling. Records that were
+ * still being written when the fault hit are lost. Never waits for ring space
+ * or for USART interrupts.
+ *
+ * @param str string to send over UART
+ * @param len length of the string
+ * @return ARM_DRIVER_OK
+ */
+int tracelib_send_polled(const char* str, uint32_t len);
+
+/**
+ * @brief Select the timestamp printed after the prefix of every trace line.
+ *
+ * Timestamps are CPU cycles from the counter used by alifs_profile.h, or the
+ * generic timer count on A32 when built with TRACELIB_TIMESTAMP_CNTPCT.
+ * Binary records of TRACELIB_DEFERRED_FORMAT always carry an absolute timestamp.
+ */
+void tracelib_set_timestamp(tracelib_timestamp_t mode);
+
+/**
+ * @brief Queue a caller owned buffer for transmission without copying it.
+ *
+ * Only a small descriptor is stored in the transmit buffer, the USART driver
+ * (and its DMA when enabled for the instance) reads the data directly from the
+ * caller's buffer in order with the rest of the output. The buffer must stay
+ * valid until release is called, which happens from the USART interrupt.
+ *
+ * @param data    buffer to send
+ * @param len     number of bytes to send
+ * @param release called when the buffer has been sent or dropped, may be NULL.
+ *                Not called when queuing fails, the caller keeps the buffer then.
+ * @param ctx     argument for release
+ * @return ARM_DRIVER_ERROR_BUSY if the transmit buffer had no room for the descriptor
+ */
+int tracelib_send_ref(const void *data, uint32_t len, tracelib_release_t release, void *ctx);
+
+/**
+ * @brief Reserve space directly in the transmit buffer.
+ *
+ * The caller fills the returned buffer and hands it over with tracelib_commit,
+ * the data is sent as is without a prefix. Reservations are transmitted in the
+ * order they were made, so keep the time between reserve and commit short.
+ * Every successful reservation must be committed.
+ *
+ * @param len number of bytes to reserve, at most a quarter of TRACELIB_TX_BUFFER_SIZE
+ * @param res reservation handle to pass to tracelib_commit
+ * @return pointer to the reserved space or NULL if the buffer is full
+ */
+void *tracelib_reserve(uint32_t len, tracelib_reservation_t *res);
+
+/**
+ * @brief Commit a reservation for transmission.
+ *
+ * @param res reservation from tracelib_reserve
+ * @param len number of bytes actually written, may be less than reserved,
+ *            0 abandons the reservation
+ */
+void tracelib_commit(const tracelib_reservation_t *res, uint32_t len);
+
+/**
+ * @brief Get the timestamp used for trace records, CPU cycles by default.
+ */
+uint32_t tracelib_timestamp(void);
+
+/*
+ * Structured records. Every record is a CBOR (RFC 8949) map of typed fields,
+ * framed so it can be found in the middle of text output and decoded to JSON
+ * on the host by logging/analyser/decode_trace.py:
+ *
+ *   u8  TRACELIB_KV_RECORD_MARKER
+ *   u16 length of the rest of the record
+ *   ... indefinite length CBOR map, the first fields are "event" (text) and
+ *       "ts" (tracelib_timestamp tagged with TRACELIB_KV_TAG_CYCLES)
+ *
+ * Fields that do not fit into TRACELIB_KV_MAX_LEN bytes are left out.
+ *
+ *   tracelib_kv_t kv;
+ *   if (tracelib_kv_begin(&kv, "adc")) {
+ *       tracelib_kv_int(&kv, "ch", 3);
+ *       tracelib_kv_float(&kv, "volts", 1.25);
+ *       tracelib_kv_end(&kv);
+ *   }
+ */
+#define TRACELIB_KV_RECORD_MARKER   0xA6
+#define TRACELIB_KV_TAG_CYCLES      6
+
+#ifndef TRACELIB_KV_MAX_LEN
+#define TRACELIB_KV_MAX_LEN 128
+#endif
+
+typedef struct {
+    tracelib_reservation_t res;
+    uint8_t *buf;           /* NULL when the record could not be started */
+    uint32_t len;
+    bool truncated;         /* a field was left out */
+} tracelib_kv_t;
+
+/**
+ * @brief Start a structured record.
+ *
+ * Reserves the record in the transmit buffer, tracelib_kv_end must follow
+ * soon. The field functions do nothing when this failed.
+ *
+ * @param event name of the record
+ * @return false if the transmit buffer is full
+ */
+bool tracelib_kv_begin(tracelib_kv_t *kv, const char *event);
+void tracelib_kv_int(tracelib_kv_t *kv, const char *key, int64_t value);
+void tracelib_kv_uint(tracelib_kv_t *kv, const char *key, uint64_t value);
+void tracelib_kv_float(tracelib_kv_t *kv, const char *key, double value);
+void tracelib_kv_str(tracelib_kv_t *kv, const char *key, const char *value);
+void tracelib_kv_bytes(tracelib_kv_t *kv, const char *key, const void *data, uint32_t len);
+
+/**
+ * @brief Add the current tracelib_timestamp as a field.
+ */
+void tracelib_kv_timestamp(tracelib_kv_t *kv, const char *key);
+
+/**
+ * @brief Finish the record and queue it for transmission.
+ */
+void tracelib_kv_end(tracelib_kv_t *kv);
+
+/*
+ * Output sinks, combine with |. Queued output goes to every selected sink,
+ * TRACELIB_SINK_NULL only consumes it (for measuring the producer side).
+ * TRACELIB_SINK_RAM keeps the newest TRACELIB_RAM_SINK_SIZE bytes in
+ * tracelib_ram_sink for a debugger, TRACELIB_SINK_ITM writes to the ITM
+ * stimulus port TRACELIB_ITM_PORT (not on A32).
+ * The default set is TRACELIB_SINKS, TRACELIB_SINK_UART unless defined.
+ */
+#define TRACELIB_SINK_NULL  0U
+#define TRACELIB_SINK_UART  (1U << 0)
+#define TRACELIB_SINK_RAM   (1U << 1)
+#define TRACELIB_SINK_ITM   (1U << 2)
+#define TRACELIB_SINK_USER  (1U << 3)
+
+typedef void (*tracelib_sink_write_t)(const void *data, uint32_t len);
+
+/**
+ * @brief Select the output sinks.
+ *
+ * The UART stays initialized for receiving when TRACELIB_SINK_UART is not
+ * selected. Has no effect on channel cores that do not drain the channel.
+ *
+ * @param sinks TRACELIB_SINK_* flags
+ */
+void tracelib_set_sinks(uint32_t sinks);
+
+/**
+ * @brief Get the selected output sinks.
+ */
+uint32_t tracelib_get_sinks(void);
+
+/**
+ * @brief Set the function called with the output for TRACELIB_SINK_USER.
+ *
+ * Called from the context draining the transmit ring, one record at a time.
+ */
+void tracelib_set_user_sink(tracelib_sink_write_t write);
+
+/**
+ * @brief Get the number of bytes recovered from before the last reset.
+ *
+ * Only with the flight recorder enabled (TRACELIB_RECORDER_SIZE), which keeps
+ * a copy of all output in a RAM section that survives a warm reset. The
+ * recovered output is overwritten by new output gradually, read or dump it
+ * soon after tracelib_init.
+ */
+uint32_t tracelib_recorder_recovered(void);
+
+/**
+ * @brief Copy recovered output, oldest first.
+ *
+ * @param offset position in the recovered output
+ * @return number of bytes copied
+ */
+uint32_t tracelib_recorder_read(uint32_t offset, void *buf, uint32_t len);
+
+/**
+ * @brief Send the recovered output between marker lines and discard it.
+ *
+ * Output from other contexts is not recorded while dumping.
+ *
+ * @return number of bytes dumped
+ */
+int tracelib_recorder_dump(void);
+
+/**
+ * @brief Discard the recovered output.
+ */
+void tracelib_recorder_clear(void);
+
+typedef void (*tracelib_shell_handler_t)(int argc, char *argv[]);
+
+/**
+ * @brief Run a control shell command received over the trace UART.
+ *
+ * Takes one complete line from the receive buffer, if available, and
+ * executes it. Call periodically from thread context, for example the main
+ * loop. Built-in commands change trace levels, the rate limit and sinks,
+ * show counters and dump the flight recorder, "help" lists them. Do not use
+ * together with stdin reads, both consume the same receive buffer.
+ *
+ * @return true if a line was executed
+ */
+bool tracelib_shell_poll(void);
+
+/**
+ * @brief Execute a shell command line, modified in place.
+ */
+void tracelib_shell_execute(char *line);
+
+/**
+ * @brief Add a command to the control shell.
+ *
+ * At most TRACELIB_SHELL_MAX_COMMANDS commands can be added. The handler gets
+ * the command name in argv[0] and runs in the context of tracelib_shell_poll.
+ *
+ * @param name command name, must stay valid
+ * @param help one line description shown by "help"
+ * @return ARM_DRIVER_ERROR if the command table is full
+ */
+int tracelib_shell_register(const char *name, const char *help, tracelib_shell_handler_t handler);
+
+/**
+ * @brief Trace the statistics of the profiling zones (profiling/alifs_zone.h),
+ *        one line per zone.
+ *
+ * @note Needs profiling/alifs_zone.c in the build, as does tracelib_zone_shell_register.
+ */
+void tracelib_zone_report(void);
+
+/**
+ * @brief Add the "zones [reset|on|off] [name]" command to the control shell.
+ *
+ * @return 0 on success, see tracelib_shell_register
+ */
+int tracelib_zone_shell_register(void);
+
+/**
+ * @brief Start transmitting output queued from deferred contexts.
+ *
+ * Needed with TRACELIB_DEFER_ISR_KICK when TRACELIB_PENDSV_KICK is not used
+ * or on A32, which has no PendSV, and in batch mode. Call it from the idle
+ * loop.
+ */
+void tracelib_process(void);
+
+/**
+ * @brief Send the output in bursts and power the UART down in between.
+ *
+ * Output is queued until threshold bytes are waiting, the oldest output is
+ * timeout_ms old or tracelib_flush is called, then the UART is powered up and
+ * everything queued is sent. tracelib_process powers the UART down again
+ * after the burst. Nothing is received while the UART is powered down.
+ * The defaults are TRACELIB_BATCH_THRESHOLD (0) and TRACELIB_BATCH_TIMEOUT_MS.
+ *
+ * @param threshold  queued bytes that start a burst, at most the transmit
+ *                   buffer size. 0 sends continuously with the UART always on.
+ * @param timeout_ms age of the oldest queued output that starts a burst,
+ *                   checked by tracef and tracelib_process
+ */
+void tracelib_set_batch(uint32_t threshold, uint32_t timeout_ms);
+
+/**
+ * @brief Wait until all queued output has been transmitted.
+ *
+ * @note Relies on the UART interrupt, must not be called with IRQs disabled.
+ */
+void tracelib_flush(void);
+
+/**
+ * @brief Get transmit buffer statistics.
+ *
+ * @param stats structure to fill
+ */
+void tracelib_get_stats(tracelib_stats_t *stats);
+
+/**
+ * @brief Reset the high water mark and dropped byte counter.
+ */
+void tracelib_reset_stats(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,40 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+#include "alifs_profile.h"
+
+#ifndef A32
+
+/*
+ * The upper 32 bits of the extended count and the last CYCCNT value seen. A wrap
+ * shows up as a CYCCNT value below the last one, so at least one read per wrap
+ * period is needed (see alifs_profile_extend).
+ */
+static uint32_t profile_high;
+static uint32_t profile_last;
+
+uint64_t alifs_profile_cycles64(void)
+{
+    // interrupts off so a preempting reader cannot count the same wrap twice
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    const uint32_t now = DWT->CYCCNT;
+    if (now < profile_last) {
+        profile_high++;
+    }
+    profile_last = now;
+    const uint64_t value = ((uint64_t)profile_high << 32) | now;
+
+    __set_PRIMASK(primask);
+    return value;
+}
+
+#endif // A32
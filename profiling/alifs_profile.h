@@ -15,6 +15,13 @@
  * As CYCCNT register is uint32_t in length, this system only supports profiling of
  * 0xFFFF FFFF (4,294,967,295) cycles which translates to approximately 10 seconds on HP core
  * and 26 seconds on HE.
+ *
+ * Longer intervals are measured with the 64-bit variants alifs_profile_start64 and
+ * alifs_profile_end64. On A32 they read PMCCNTR as a 64-bit counter. On M55 CYCCNT is
+ * extended in software (alifs_profile.c), which only notices a wrap if the counter is
+ * read at least once per wrap period. The SysTick handler of retarget.c calls
+ * alifs_profile_extend when RETARGET_PROFILE_EXTEND is defined, applications
+ * without it have to call it periodically.
  */
 
 #ifndef ALIFS_PROFILE_H_
@@ -31,7 +38,7 @@
 #define PMCR_E_BIT 0
 #define PMCR_LC_BIT 6
 
-__STATIC_FORCEINLINE uint32_t alifs_profile_start()
+__STATIC_FORCEINLINE void alifs_profile_enable(void)
 {
     uint32_t value;
 
@@ -46,6 +53,13 @@ __STATIC_FORCEINLINE uint32_t alifs_profile_start()
     value |= ((1 << PMCR_LC_BIT) |
               (1 << PMCR_E_BIT));
     __set_CP(15, 0, value, 9, 12, 0);
+}
+
+__STATIC_FORCEINLINE uint32_t alifs_profile_start()
+{
+    uint32_t value;
+
+    alifs_profile_enable();
 
     //read current cyclecounter value
     __get_CP(15, 0, value, 9, 13, 0);
@@ -59,15 +73,53 @@ __STATIC_FORCEINLINE uint32_t alifs_profile_end(const uint32_t counter_start_val
   return (value - counter_start_value);
 }
 
+/*
+ * Return the 64-bit cycle count, PMCR.LC makes the whole PMCCNTR count.
+ */
+__STATIC_FORCEINLINE uint64_t alifs_profile_cycles64(void)
+{
+    uint64_t value;
+    __get_CP64(15, 0, value, 9);
+    return value;
+}
+
+// Nothing to extend, PMCCNTR is 64 bits wide
+__STATIC_FORCEINLINE void alifs_profile_extend(void)
+{
+}
+
+/*
+ * Generic timer count (CNTPCT) and frequency (CNTFRQ). CMSIS 6 has __get_CNTPCT and
+ * __get_CNTFRQ for these, the registers are read directly to work with CMSIS 5 as well.
+ */
+__STATIC_FORCEINLINE uint64_t alifs_profile_cntpct(void)
+{
+    uint64_t value;
+    __get_CP64(15, 1, value, 14);
+    return value;
+}
+
+__STATIC_FORCEINLINE uint32_t alifs_profile_cntfrq(void)
+{
+    uint32_t value;
+    __get_CP(15, 0, value, 14, 0, 0);
+    return value;
+}
+
 #else
+__STATIC_FORCEINLINE void alifs_profile_enable(void)
+{
+    DCB->DEMCR |= DCB_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
 /*
  * Start Cycle counter (if it's not started yet) and return the initial cycle count.
  * @return the initial cycle count from tracing register.
  */
 __STATIC_FORCEINLINE uint32_t alifs_profile_start()
 {
-    DCB->DEMCR |= DCB_DEMCR_TRCENA_Msk;
-    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    alifs_profile_enable();
     return DWT->CYCCNT;
 }
 
@@ -81,8 +133,49 @@ __STATIC_FORCEINLINE uint32_t alifs_profile_end(const uint32_t counter_start_val
 {
     return (DWT->CYCCNT - counter_start_value);
 }
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Return CYCCNT extended to 64 bits. Safe from threads and ISRs.
+ */
+uint64_t alifs_profile_cycles64(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/*
+ * Keep the 64-bit count in step with CYCCNT. Has to run at least once every 2^32 cycles
+ * (10 s on HP), e.g. from a timer interrupt, unless alifs_profile_cycles64 is called anyway.
+ */
+__STATIC_FORCEINLINE void alifs_profile_extend(void)
+{
+    (void)alifs_profile_cycles64();
+}
 #endif
 
+/*
+ * Start the cycle counter (if it's not started yet) and return the initial 64-bit cycle count.
+ */
+__STATIC_FORCEINLINE uint64_t alifs_profile_start64(void)
+{
+    alifs_profile_enable();
+    return alifs_profile_cycles64();
+}
+
+/*
+ * Return the elapsed cycles, without the 2^32 cycle limit of alifs_profile_end.
+ *
+ * @param counter_start_value The value returned by alifs_profile_start64 -function.
+ */
+__STATIC_FORCEINLINE uint64_t alifs_profile_end64(const uint64_t counter_start_value)
+{
+    return alifs_profile_cycles64() - counter_start_value;
+}
+
 /*
  * Return the approximate number of nanoseconds the given cycle count corresponds to.
  * (calculation is done with integer arithmetic which always rounds towards floor)
@@ -96,4 +189,15 @@ __STATIC_INLINE uint32_t alifs_profile_cycles_to_ns(const uint32_t counter_value
     return (uint32_t)(temp / GetSystemCoreClock());
 }
 
+/*
+ * Return the number of microseconds the given 64-bit cycle count corresponds to (rounded down).
+ *
+ * @param counter_value The number of cycles used, e.g. from alifs_profile_end64.
+ */
+__STATIC_INLINE uint64_t alifs_profile_cycles64_to_us(const uint64_t counter_value)
+{
+    const uint32_t clock = GetSystemCoreClock();
+    return counter_value / clock * 1000000 + counter_value % clock * 1000000 / clock;
+}
+
 #endif // #ifndef ALIFS_PROFILE_H_
@@ -0,0 +1,128 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "alifs_zone.h"
+
+#ifndef ALIFS_ZONE_DEFAULT_ENABLED
+#define ALIFS_ZONE_DEFAULT_ENABLED 1
+#endif
+
+volatile bool alifs_zones_enabled = ALIFS_ZONE_DEFAULT_ENABLED;
+
+// Bounds of the alifs_zones section, see alifs_zone.h
+#if defined(__ICCARM__)
+#pragma section = "alifs_zones"
+#define ZONES_BEGIN ((const alifs_zone_t *)__section_begin("alifs_zones"))
+#define ZONES_END   ((const alifs_zone_t *)__section_end("alifs_zones"))
+#elif defined(__ARMCC_VERSION)
+extern const alifs_zone_t Image$$ALIFS_ZONES$$Base[] __attribute__((weak));
+extern const alifs_zone_t Image$$ALIFS_ZONES$$Limit[] __attribute__((weak));
+#define ZONES_BEGIN Image$$ALIFS_ZONES$$Base
+#define ZONES_END   Image$$ALIFS_ZONES$$Limit
+#else
+// only defined by the linker when there is at least one zone
+extern const alifs_zone_t __start_alifs_zones[] __attribute__((weak));
+extern const alifs_zone_t __stop_alifs_zones[] __attribute__((weak));
+#define ZONES_BEGIN __start_alifs_zones
+#define ZONES_END   __stop_alifs_zones
+#endif
+
+static inline uint32_t zone_lock(void)
+{
+#ifdef A32
+    const uint32_t cpsr = __get_CPSR();
+    __disable_irq();
+    return cpsr & CPSR_I_Msk;
+#else
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    return primask;
+#endif
+}
+
+static inline void zone_unlock(uint32_t state)
+{
+    if (state == 0) {
+        __enable_irq();
+    }
+}
+
+void alifs_zone_record(const alifs_zone_t *zone, uint32_t cycles)
+{
+    alifs_zone_stats_t *stats = zone->stats;
+    const uint32_t state = zone_lock();
+
+    stats->count++;
+    stats->last = cycles;
+    if (cycles < stats->min) {
+        stats->min = cycles;
+    }
+    if (cycles > stats->max) {
+        stats->max = cycles;
+    }
+    stats->sum += cycles;
+    stats->sum_sq += (double)cycles * cycles;
+
+    zone_unlock(state);
+}
+
+void alifs_zone_get_stats(const alifs_zone_t *zone, alifs_zone_stats_t *stats)
+{
+    const uint32_t state = zone_lock();
+    *stats = *zone->stats;
+    zone_unlock(state);
+}
+
+void alifs_zone_reset(const alifs_zone_t *zone)
+{
+    const alifs_zone_t *begin = zone ? zone : ZONES_BEGIN;
+    const alifs_zone_t *end = zone ? zone + 1 : ZONES_END;
+
+    for (const alifs_zone_t *z = begin; z < end; z++) {
+        const uint32_t state = zone_lock();
+        *z->stats = (alifs_zone_stats_t){ .min = UINT32_MAX };
+        zone_unlock(state);
+    }
+}
+
+void alifs_zone_enable(const alifs_zone_t *zone, bool enable)
+{
+    if (zone == NULL) {
+        alifs_zones_enabled = enable;
+    } else {
+        *zone->enabled = enable;
+    }
+}
+
+uint32_t alifs_zone_count(void)
+{
+    if (ZONES_BEGIN == NULL) {
+        return 0;
+    }
+    return ZONES_END - ZONES_BEGIN;
+}
+
+const alifs_zone_t *alifs_zone_at(uint32_t index)
+{
+    return index < alifs_zone_count() ? &ZONES_BEGIN[index] : NULL;
+}
+
+const alifs_zone_t *alifs_zone_find(const char *name)
+{
+    for (uint32_t i = 0; i < alifs_zone_count(); i++) {
+        if (strcmp(ZONES_BEGIN[i].name, name) == 0) {
+            return &ZONES_BEGIN[i];
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,183 @@
+/* Copyright (C) 2022 Alif Semiconductor - All Rights Reserved.
+ * Use, distribution and modification of this code is permitted under the
+ * terms stated in the Alif Semiconductor Software License Agreement
+ *
+ * You should have received a copy of the Alif Semiconductor Software
+ * License Agreement with this file. If not, please write to:
+ * contact@alifsemi.com, or visit: https://alifsemi.com/license
+ *
+ */
+
+/*
+ * Named profiling zones with aggregated statistics.
+ *
+ * A zone is defined once at file scope and measured with begin/end macros or,
+ * in C++, a scoped guard:
+ *
+ *   ALIFS_ZONE_DEFINE(zone_preprocess, "preprocess");
+ *
+ *   ALIFS_ZONE_BEGIN(zone_preprocess);
+ *   preprocess(frame);
+ *   ALIFS_ZONE_END(zone_preprocess);
+ *
+ *   { ALIFS_ZONE_SCOPE(zone_preprocess); preprocess(frame); }
+ *
+ * The zone descriptors are collected in the alifs_zones linker section so all
+ * zones can be listed without registering them at runtime. GNU ld, lld and
+ * IAR provide the section bounds themselves. With armlink the scatter file
+ * needs an execution region for the section:
+ *
+ *   ALIFS_ZONES +0 { *(alifs_zones) }
+ *
+ * Durations are measured with alifs_profile_start/alifs_profile_end, so a
+ * single measurement must stay below 2^32 cycles.
+ *
+ * The zones are listed with tracelib_zone_report and the "zones" command of
+ * the tracelib control shell (logging/trace_zone.c), which also switches
+ * them off one by one or all together at runtime. A disabled zone costs a
+ * flag check in ALIFS_ZONE_BEGIN and ALIFS_ZONE_END and keeps its
+ * statistics. Define ALIFS_ZONE_DEFAULT_ENABLED as 0 to start with all
+ * zones off.
+ */
+
+#ifndef ALIFS_ZONE_H_
+#define ALIFS_ZONE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "alifs_profile.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t count;     /* completed measurements */
+    uint32_t min;       /* cycles */
+    uint32_t max;
+    uint32_t last;
+    uint64_t sum;
+    double sum_sq;      /* sum of squared cycles, for the standard deviation */
+} alifs_zone_stats_t;
+
+typedef struct {
+    const char *name;
+    alifs_zone_stats_t *stats;
+    volatile bool *enabled;     /* see alifs_zone_enable */
+} alifs_zone_t;
+
+/* Switch for all zones, see alifs_zone_enable */
+extern volatile bool alifs_zones_enabled;
+
+#if defined(__ICCARM__)
+#define ALIFS_ZONE_SECTION _Pragma("location=\"alifs_zones\"") __root
+#else
+// the explicit alignment keeps the compiler from padding the entries apart
+#define ALIFS_ZONE_SECTION __attribute__((used, section("alifs_zones"), aligned(sizeof(void *))))
+#endif
+
+/**
+ * @brief Define a zone, use ALIFS_ZONE_DECLARE to measure it in other files.
+ */
+#define ALIFS_ZONE_DEFINE(zone, zone_name)                                      \
+    static alifs_zone_stats_t zone##_stats_ = { 0, UINT32_MAX, 0, 0, 0, 0.0 };  \
+    static volatile bool zone##_enabled_ = true;                                \
+    ALIFS_ZONE_DECLARE(zone);                                                   \
+    ALIFS_ZONE_SECTION const alifs_zone_t zone = { (zone_name), &zone##_stats_, &zone##_enabled_ }
+
+// also gives the definition external linkage in C++
+#define ALIFS_ZONE_DECLARE(zone) extern const alifs_zone_t zone
+
+/**
+ * @brief Check whether zone is measured, both the zone and all zones must be enabled.
+ */
+__STATIC_FORCEINLINE bool alifs_zone_enabled(const alifs_zone_t *zone)
+{
+    return alifs_zones_enabled && *zone->enabled;
+}
+
+/**
+ * @brief Start measuring zone, ALIFS_ZONE_END must follow in the same scope.
+ *
+ * Nothing is measured if the zone is disabled here, enabling it before
+ * ALIFS_ZONE_END takes effect from the next ALIFS_ZONE_BEGIN.
+ */
+#define ALIFS_ZONE_BEGIN(zone)                                                              \
+    const bool alifs_zone_on_##zone = alifs_zone_enabled(&(zone));                          \
+    const uint32_t alifs_zone_start_##zone = alifs_zone_on_##zone ? alifs_profile_start() : 0
+
+#define ALIFS_ZONE_END(zone)                                                                \
+    (alifs_zone_on_##zone ? alifs_zone_record(&(zone), alifs_profile_end(alifs_zone_start_##zone)) : (void)0)
+
+/**
+ * @brief Add a measurement to the zone statistics. Safe from threads and ISRs.
+ *
+ * Records even if the zone is disabled, the macros check alifs_zone_enabled.
+ */
+void alifs_zone_record(const alifs_zone_t *zone, uint32_t cycles);
+
+/**
+ * @brief Get a consistent copy of the zone statistics.
+ */
+void alifs_zone_get_stats(const alifs_zone_t *zone, alifs_zone_stats_t *stats);
+
+/**
+ * @brief Clear the statistics of one zone, or of all zones when zone is NULL.
+ */
+void alifs_zone_reset(const alifs_zone_t *zone);
+
+/**
+ * @brief Enable or disable one zone, or all zones when zone is NULL.
+ *
+ * The switch for all zones is separate from the zone switches, a zone is
+ * measured when both are on.
+ */
+void alifs_zone_enable(const alifs_zone_t *zone, bool enable);
+
+/**
+ * @brief Number of zones in the image.
+ */
+uint32_t alifs_zone_count(void);
+
+/**
+ * @brief Get a zone by index (0 .. alifs_zone_count() - 1), in link order.
+ */
+const alifs_zone_t *alifs_zone_at(uint32_t index);
+
+/**
+ * @brief Find a zone by name.
+ *
+ * @return the zone or NULL
+ */
+const alifs_zone_t *alifs_zone_find(const char *name);
+
+#ifdef __cplusplus
+}
+
+/*
+ * Measures the enclosing scope, see ALIFS_ZONE_SCOPE.
+ */
+class alifs_zone_guard {
+public:
+    explicit alifs_zone_guard(const alifs_zone_t &zone)
+        : zone_(zone), on_(alifs_zone_enabled(&zone)), start_(on_ ? alifs_profile_start() : 0) {}
+    ~alifs_zone_guard()
+    {
+        if (on_) {
+            alifs_zone_record(&zone_, alifs_profile_end(start_));
+        }
+    }
+
+    alifs_zone_guard(const alifs_zone_guard &) = delete;
+    alifs_zone_guard &operator=(const alifs_zone_guard &) = delete;
+
+private:
+    const alifs_zone_t &zone_;
+    const bool on_;
+    const uint32_t start_;
+};
+
+#define ALIFS_ZONE_SCOPE(zone) alifs_zone_guard alifs_zone_guard_##zone(zone)
+#endif
+
+#endif /* ALIFS_ZONE_H_ */